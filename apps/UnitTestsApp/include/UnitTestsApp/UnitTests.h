@@ -21,4 +21,10 @@ class UnitTests {
 											bool allow_negation) {
 		return AlgExpression::parse_string(str, allow_ref, allow_negation);
 	}
+	static bool from_string(AlgExpression& expr, // NOLINT(runtime/references)
+							const std::string& str,
+							size_t& error_position, // NOLINT(runtime/references)
+							bool allow_ref = false, bool allow_negation = true) {
+		return expr.from_string(str, error_position, allow_ref, allow_negation);
+	}
 };
@@ -1,12 +1,25 @@
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
 #include "UnitTestsApp/UnitTests.h"
 #include "AutomatonToImage/AutomatonToImage.h"
+#include "Fraction/Fraction.h"
 #include "Interpreter/Interpreter.h"
 #include "Objects/AlgExpression.h"
 #include "Objects/BackRefRegex.h"
+#include "Objects/BitParallelMatcher.h"
+#include "Objects/DFAMatcher.h"
 #include "Objects/FiniteAutomaton.h"
 #include "Objects/Grammar.h"
 #include "Objects/Language.h"
+#include "Objects/LazyDFAMatcher.h"
 #include "Objects/MemoryFiniteAutomaton.h"
+#include "Objects/MultiPatternMatcher.h"
+#include "Objects/PathCounter.h"
+#include "Objects/RegexDAG.h"
+#include "Objects/RegexDerivatives.h"
+#include "Objects/StreamMatcher.h"
 #include "Objects/Regex.h"
 #include "Objects/TransformationMonoid.h"
 #include "Tester/Tester.h"
@@ -74,6 +87,60 @@ TEST(TestParseString, FromString) {
 	}
 }
 
+TEST(TestParseString, LanguageAlphabet) {
+	string str;
+	for (int i = 0; i < 500; i++)
+		str += "(ab|c)*";
+	Regex r(str + "d");
+	ASSERT_EQ(r.get_language()->get_alphabet(), Alphabet({"a", "b", "c", "d"}));
+	ASSERT_EQ(Regex(r).get_language()->get_alphabet(), Alphabet({"a", "b", "c", "d"}));
+	ASSERT_TRUE(Regex("").get_language()->get_alphabet().empty());
+}
+
+TEST(TestParseString, ErrorPosition) {
+	struct Test {
+		string regex_str;
+		bool bref;
+		size_t error_position;
+	};
+
+	vector<Test> tests = {
+		{"a(*b)", false, 2},
+		{"ab)", false, 2},
+		{"(ab", false, 3},
+		{"a|^*", false, 3},
+		{"[a]:1[b&1]:1", true, 7},
+		{"[a]:1[*b]:2", true, 6},
+	};
+
+	for (const auto& t : tests) {
+		SCOPED_TRACE("Case: " + t.regex_str);
+		size_t error_position = 0;
+		if (t.bref) {
+			BackRefRegex r;
+			ASSERT_FALSE(UnitTests::from_string(r, t.regex_str, error_position, true, false));
+		} else {
+			Regex r;
+			ASSERT_FALSE(UnitTests::from_string(r, t.regex_str, error_position));
+		}
+		ASSERT_EQ(error_position, t.error_position);
+	}
+
+	// длинные выражения разбираются за один проход
+	string str;
+	for (int i = 0; i < 20000; i++)
+		str += "(ab|c)*";
+	Regex r(str);
+	ASSERT_EQ(r.get_language()->get_alphabet(), Alphabet({"a", "b", "c"}));
+
+	// глубина дерева конкатенаций равна числу символов: ни разбор, ни удаление
+	// не должны переполнять стек
+	Regex flat(string(300000, 'a'));
+	ASSERT_EQ(flat.get_language()->get_alphabet(), Alphabet({"a"}));
+	BackRefRegex flat_bref(string(300000, 'a') + "[b]:1&1");
+	ASSERT_EQ(flat_bref.get_type(), BackRefRegex::Type::conc);
+}
+
 TEST(TestNegativeRegex, Thompson) {
 	vector<FAState> states;
 	for (int i = 0; i < 9; i++) {
@@ -112,6 +179,39 @@ TEST(TestNegativeRegex, Thompson) {
 	ASSERT_TRUE(FiniteAutomaton::equal(fa, Regex("(^a|b)c").to_thompson()));
 }
 
+TEST(TestThompson, FragmentLayout) {
+	vector<FAState> states;
+	for (int i = 0; i < 9; i++) {
+		states.emplace_back(i, set<int>{i}, std::to_string(i), false, FAState::Transitions());
+	}
+
+	states[0].set_transition(1, Symbol::Epsilon);
+	states[0].set_transition(7, Symbol::Epsilon);
+	states[1].set_transition(2, Symbol::Epsilon);
+	states[1].set_transition(4, Symbol::Epsilon);
+	states[2].set_transition(3, "a");
+	states[3].set_transition(6, Symbol::Epsilon);
+	states[4].set_transition(5, "b");
+	states[5].set_transition(6, Symbol::Epsilon);
+	states[6].set_transition(1, Symbol::Epsilon);
+	states[6].set_transition(7, Symbol::Epsilon);
+	// финальное состояние итерации совпадает с начальным состоянием c
+	states[7].set_transition(8, "c");
+	states[8].is_terminal = true;
+	FiniteAutomaton fa(0, states, {"a", "b", "c"});
+
+	ASSERT_TRUE(FiniteAutomaton::equal(fa, Regex("(a|b)*c").to_thompson()));
+
+	string str, word;
+	for (int i = 0; i < 500; i++) {
+		str += "(ab|c)*";
+		word += i % 2 ? "ab" : "c";
+	}
+	FiniteAutomaton long_fa = Regex(str).to_thompson();
+	ASSERT_EQ(long_fa.size(), 4001);
+	ASSERT_TRUE(long_fa.parse(word).second);
+}
+
 TEST(TestNegativeRegex, Antimirov) {
 	vector<FAState> states;
 	for (int i = 0; i < 5; i++) {
@@ -141,6 +241,22 @@ TEST(TestNegativeRegex, Antimirov) {
 	ASSERT_TRUE(FiniteAutomaton::equal(fa, Regex("(^a|b)c").to_antimirov()));
 }
 
+TEST(TestNegativeRegex, Derivatives) {
+	// производная сохраняет алфавит исходного выражения, и дополнение берётся по нему,
+	// даже если символа алфавита в производной уже нет
+	ASSERT_TRUE(Regex("a^(b)").to_thompson().parse("aa").second);
+	std::optional<Regex> d_a = Regex("a^(b)").symbol_derivative(Regex("a"));
+	ASSERT_TRUE(d_a.has_value());
+	ASSERT_EQ(d_a->get_language()->get_alphabet(), Alphabet({"a", "b"}));
+	ASSERT_TRUE(d_a->to_thompson().parse("a").second);
+	ASSERT_FALSE(d_a->to_thompson().parse("b").second);
+
+	std::optional<Regex> d_b = Regex("^(b)").symbol_derivative(Regex("b"));
+	ASSERT_TRUE(d_b.has_value());
+	ASSERT_TRUE(d_b->to_thompson().parse("b").second);
+	ASSERT_FALSE(d_b->to_thompson().parse("").second);
+}
+
 TEST(TestEqual, FA_Equal) {
 	vector<FAState> states1;
 	for (int i = 0; i < 6; i++) {
@@ -233,6 +349,27 @@ TEST(TestEquivalent, FA_Equivalent) {
 	ASSERT_TRUE(FiniteAutomaton::equivalent(fa1, fa2));
 }
 
+TEST(TestEquivalent, FA_DistinguishingWord) {
+	auto get_word = [](const string& rgx_str1, const string& rgx_str2) {
+		auto word = FiniteAutomaton::get_distinguishing_word(Regex(rgx_str1).to_thompson(),
+															 Regex(rgx_str2).to_glushkov());
+		return word.has_value() ? std::optional<string>(Symbol::vector_to_str(*word))
+								: std::nullopt;
+	};
+
+	ASSERT_EQ(get_word("(a|b)*", "(a*b*)*"), std::nullopt);
+	ASSERT_EQ(get_word("a*", "aa*"), "");
+	ASSERT_EQ(get_word("(ab)*", "(ab)*|abab*"), "aba");
+	ASSERT_EQ(get_word("(a|b)*a(a|b)", "(a|b)*a(a|b)(a|b)"), "aa");
+
+	// различающего слова нет, но алфавиты различаются
+	auto alphabet_ab = [] { return std::make_shared<Language>(Alphabet({"a", "b"})); };
+	Regex wide("a", alphabet_ab());
+	ASSERT_FALSE(FiniteAutomaton::equivalent(Regex("a").to_thompson(), wide.to_thompson()));
+	ASSERT_TRUE(FiniteAutomaton::equivalent(Regex("a", alphabet_ab()).to_thompson(),
+											wide.to_glushkov()));
+}
+
 TEST(TestBisimilar, FA_Bisimilar) {
 	vector<FAState> states1;
 	for (int i = 0; i < 3; i++) {
@@ -301,6 +438,32 @@ TEST(TestBisimilar, FA_MergeBisimilar) {
 	ASSERT_TRUE(FiniteAutomaton::equal(fa2.merge_bisimilar(), fa3));
 }
 
+TEST(TestBisimilar, FA_MergeBisimilarNondeterministic) {
+	// 0 и 1 ведут по a в оба состояния {3, 4}, 2 - только в финальное 3;
+	// 0 и 1 бисимилярны, 2 отделяется лишь по отсутствию перехода в 4
+	vector<FAState> states;
+	for (int i = 0; i < 5; i++) {
+		states.emplace_back(i, set<int>({i}), std::to_string(i), false, FAState::Transitions());
+	}
+	states[0].set_transition(1, "b");
+	states[0].set_transition(3, "a");
+	states[0].set_transition(4, "a");
+	states[1].set_transition(1, "b");
+	states[1].set_transition(3, "a");
+	states[1].set_transition(4, "a");
+	states[2].set_transition(3, "a");
+	states[2].set_transition(2, "b");
+	states[4].set_transition(4, "b");
+	states[3].is_terminal = true;
+	FiniteAutomaton fa(0, states, {"a", "b"});
+	FiniteAutomaton merged = fa.merge_bisimilar();
+
+	ASSERT_EQ(merged.size(), 4);
+	ASSERT_TRUE(FiniteAutomaton::bisimilar(fa, merged));
+	ASSERT_FALSE(FiniteAutomaton::bisimilar(fa, Regex("b*a").to_glushkov()));
+	ASSERT_TRUE(FiniteAutomaton::equal(merged, merged.merge_bisimilar()));
+}
+
 TEST(TestSubset, Regex_Subset) {
 	Regex r1("a*baa");
 	Regex r2("abaa");
@@ -308,6 +471,22 @@ TEST(TestSubset, Regex_Subset) {
 	ASSERT_TRUE(r1.subset(r2));
 	ASSERT_TRUE(!r2.subset(r1));
 	ASSERT_TRUE(!Regex("ab*").subset(Regex("a*b*")));
+
+	FiniteAutomaton fa1 = Regex("(a|b)*").to_thompson();
+	FiniteAutomaton fa2 = Regex("a*b").to_thompson();
+	ASSERT_TRUE(fa1.subset(fa2));
+	ASSERT_FALSE(fa2.subset(fa1));
+	ASSERT_TRUE(fa2.subset(Regex("aab|b").to_glushkov()));
+}
+
+TEST(TestIntersection, FA_Intersection) {
+	FiniteAutomaton fa1 = Regex("(a|b)*a").to_thompson();
+	FiniteAutomaton fa2 = Regex("a(a|b)*").to_thompson();
+	FiniteAutomaton fa = FiniteAutomaton::intersection(fa1, fa2);
+
+	ASSERT_TRUE(FiniteAutomaton::equivalent(fa, Regex("a|a(a|b)*a").to_glushkov()));
+	// строятся только достижимые пары состояний
+	ASSERT_LT(fa.size(), fa1.size() * fa2.size());
 }
 
 TEST(TestEqual, Regex_Equal) {
@@ -337,6 +516,126 @@ TEST(TestRemoveTrap, FASizeEquality) {
 	ASSERT_EQ(fa3.size(), fa3.remove_trap_states().size()); // Кейс, когда ловушек нет.
 }
 
+TEST(TestMinimize, FA_Minimize) {
+	ASSERT_EQ(Regex("(a|b)*a(a|b)(a|b)").to_thompson().minimize().size(), 8);
+	ASSERT_EQ(Regex("ab").to_glushkov().minimize().size(), 4);
+	ASSERT_EQ(Regex("ab").to_glushkov().minimize(true).size(), 3);
+
+	// неполный ДКА без ловушки
+	vector<FAState> states;
+	for (int i = 0; i < 4; i++) {
+		states.emplace_back(i, set<int>{i}, std::to_string(i), false, FAState::Transitions());
+	}
+	states[0].set_transition(1, "a");
+	states[0].set_transition(3, "b");
+	states[1].set_transition(2, "b");
+	states[3].set_transition(2, "b");
+	states[2].is_terminal = true;
+	FiniteAutomaton fa(0, states, {"a", "b"});
+
+	FiniteAutomaton min_fa = fa.minimize(true);
+	ASSERT_EQ(min_fa.size(), 3);
+	ASSERT_TRUE(FiniteAutomaton::equivalent(min_fa, Regex("(a|b)b").to_glushkov()));
+}
+
+TEST(TestPositionDFA, MatchesGlushkovDeterminization) {
+	string long_rgx_str;
+	for (int i = 0; i < 40; i++)
+		long_rgx_str += "(ab|c)*";
+	vector<string> rgx_strs = {
+		"(a|b)*a", "a(bbb*aaa*)*bb*|aaa*(bbb*aaa*)*|b(aaa*bbb*)*aa*|", "c(|a)b*", long_rgx_str};
+	for (const string& rgx_str : rgx_strs) {
+		ASSERT_EQ(Regex(rgx_str).to_dfa().to_txt(),
+				  Regex(rgx_str).to_glushkov().determinize().to_txt());
+		ASSERT_EQ(Regex(rgx_str).to_dfa(true).to_txt(),
+				  Regex(rgx_str).to_glushkov().minimize().to_txt());
+	}
+}
+
+TEST(TestTransitionTable, FA_TransitionTable) {
+	FiniteAutomaton fa = Regex("(ab|a)*c").to_thompson();
+	FATransitionTable table = fa.get_transition_table();
+	vector<FAState> states = fa.get_states();
+
+	ASSERT_EQ(table.states_count(), states.size());
+	ASSERT_EQ(table.alphabet_size(), 3);
+	ASSERT_EQ(table.get_symbol(*table.find_symbol('b')), Symbol("b"));
+	ASSERT_TRUE(table.get_epsilon().has_value());
+	ASSERT_FALSE(table.find_symbol('d').has_value());
+
+	size_t transitions_count = 0;
+	for (const auto& state : states)
+		for (const auto& [symbol, states_to] : state.transitions) {
+			auto targets = table.get_transitions(state.index, *table.find_symbol(symbol));
+			ASSERT_EQ(set<int>(targets.begin(), targets.end()), states_to);
+			transitions_count += states_to.size();
+		}
+	ASSERT_EQ(table.transitions_count(), transitions_count);
+}
+
+TEST(TestRegexMove, Move) {
+	Regex r("(ab|c)*ab");
+	string txt = r.to_txt();
+	Regex moved(std::move(r));
+	ASSERT_EQ(moved.to_txt(), txt);
+	// перемещённое выражение остаётся корректным (eps без языка)
+	ASSERT_EQ(r.to_txt(), "");
+	ASSERT_TRUE(r.to_thompson().parse("").second);
+	ASSERT_TRUE(r.to_glushkov().parse("").second);
+	ASSERT_TRUE(r.to_dfa(true).parse("").second);
+	vector<Regex> regexes;
+	for (int i = 0; i < 100; i++)
+		regexes.push_back(moved);
+	r = std::move(regexes.back());
+	ASSERT_TRUE(Regex::equal(r, moved));
+
+	BackRefRegex br("[a*]:1b&1");
+	string br_txt = br.to_txt();
+	BackRefRegex br_moved(std::move(br));
+	ASSERT_EQ(br_moved.to_txt(), br_txt);
+	ASSERT_TRUE(br.to_mfa().parse("").second);
+	br = std::move(br_moved);
+	ASSERT_EQ(br.to_txt(), br_txt);
+}
+
+TEST(TestRegexMove, NodePoolThreads) {
+	Regex r("(ab|c)*ab");
+	// узлы, созданные в завершившемся потоке, освобождаются в основном
+	vector<Regex> from_thread;
+	std::thread([&from_thread, &r] {
+		for (int i = 0; i < 100; i++)
+			from_thread.push_back(r);
+	}).join();
+	for (const auto& regex : from_thread)
+		ASSERT_TRUE(Regex::equal(regex, r));
+	from_thread.clear();
+
+	// выражения строятся в основном потоке и удаляются в другом: освобождённые там узлы
+	// возвращаются в пул основного потока
+	for (int round = 0; round < 20; round++) {
+		vector<Regex> to_thread(100, r);
+		std::thread([regexes = std::move(to_thread)]() mutable { regexes.clear(); }).join();
+	}
+	ASSERT_TRUE(Regex::equal(Regex("(ab|c)*ab"), r));
+}
+
+TEST(TestRegexDAG, Interning) {
+	RegexDAG dag;
+	int r1 = dag.add(Regex("(ab|c)*ab")), r2 = dag.add(Regex("(ab|c)*ab"));
+	ASSERT_EQ(r1, r2);
+	ASSERT_NE(r1, dag.add(Regex("(ab|c)*ba")));
+	ASSERT_EQ(dag.to_regex(r1).to_txt(), Regex("(ab|c)*ab").to_txt());
+	// повторное добавление не создаёт узлов, а оба операнда conc - один узел
+	int size = dag.size();
+	dag.add(Regex("(ab|c)*ab"));
+	ASSERT_EQ(dag.size(), size);
+	int r3 = dag.conc(r1, r1);
+	ASSERT_EQ(dag.size(), size + 1);
+	ASSERT_EQ(dag.to_regex(r3).to_txt(), Regex("(ab|c)*ab(ab|c)*ab").to_txt());
+	ASSERT_TRUE(Regex::equivalent(Regex("(ab|c)*ab"),
+								  Regex("(ab|c)*ab").to_glushkov().to_regex()));
+}
+
 TEST(TestEquivalent, Regex_Equivalence) {
 	auto test_equivalence = [](const string& rgx_str) {
 		Regex r1(rgx_str), r2(rgx_str);
@@ -344,6 +643,7 @@ TEST(TestEquivalent, Regex_Equivalence) {
 		ASSERT_TRUE(Regex::equivalent(r1, r2.to_glushkov().to_regex()));
 		ASSERT_TRUE(Regex::equivalent(r1, r2.to_ilieyu().to_regex()));
 		ASSERT_TRUE(Regex::equivalent(r1, r2.to_antimirov().to_regex()));
+		ASSERT_TRUE(Regex::equivalent(r1, r2.to_brzozowski().to_regex()));
 	};
 
 	test_equivalence("a");
@@ -358,6 +658,32 @@ TEST(TestEquivalent, Regex_Equivalence) {
 	test_equivalence("(((((a*)((a*)|bb)(((|||((b)))))))))");
 }
 
+TEST(TestDerivatives, Brzozowski) {
+	RegexDerivatives derivatives;
+	int r = derivatives.add(Regex("(a|a)*"));
+	ASSERT_EQ(derivatives.prefix_derivative(r, "aaaa"), r);
+	ASSERT_EQ(derivatives.prefix_derivative(r, "ab"), derivatives.empty_set());
+	// ACI: порядок и повторы слагаемых не порождают новых производных
+	ASSERT_EQ(derivatives.add(Regex("c|b|c")), derivatives.add(Regex("b|c")));
+	ASSERT_EQ(Regex("ab|ac").symbol_derivative(Regex("a"))->to_txt(), "b|c");
+	ASSERT_FALSE(Regex("ab").prefix_derivative("b").has_value());
+	// производная сохраняет алфавит исходного выражения и пригодна для построения автоматов
+	std::optional<Regex> derivative = Regex("ab*").prefix_derivative("a");
+	ASSERT_TRUE(derivative.has_value());
+	ASSERT_EQ(derivative->get_language()->get_alphabet_size(), 2);
+	ASSERT_TRUE(derivative->to_thompson().parse("bb").second);
+	ASSERT_FALSE(Regex("ab").symbol_derivative(Regex("a"))->to_glushkov().parse("a").second);
+
+	ASSERT_EQ(Regex("(a|b)*abb").to_brzozowski().size(), 4);
+	for (const string& str : {"(a|b)*abb", "(ab|a)*(ba|b)*", "a*(b*)*a", "(^a|b)c"}) {
+		SCOPED_TRACE("Case: " + str);
+		Regex regex(str);
+		FiniteAutomaton dfa = regex.to_brzozowski();
+		ASSERT_TRUE(dfa.is_deterministic());
+		ASSERT_TRUE(FiniteAutomaton::equivalent(dfa, regex.to_thompson()));
+	}
+}
+
 TEST(TestPumpLength, PumpLengthValues) {
 	ASSERT_EQ(Regex("abaa").pump_length(), 5);
 }
@@ -411,6 +737,26 @@ TEST(TestIsOneUnambigous, IsOneUnambigousWorks) {
 	ASSERT_TRUE(!r5.to_glushkov().is_one_unambiguous());
 }
 
+TEST(TestIsOneUnambigous, PositionAutomaton) {
+	for (const string& rgx_str :
+		 {"(a|b)*a", "a*a", "ab|ac", "b*a(b*a)*", "(a*b*)*", "(c(a|b)*c)*"}) {
+		Regex r(rgx_str);
+		ASSERT_EQ(r.is_one_unambiguous(), r.to_glushkov().is_deterministic());
+	}
+
+	// 4000 позиций: first/last каждой ноды вычисляются один раз
+	string str;
+	for (int i = 0; i < 1000; i++)
+		str += "(ab|c)*d";
+	Regex r(str);
+	FiniteAutomaton fa = r.to_glushkov();
+	ASSERT_EQ(fa.size(), 4001);
+	ASSERT_TRUE(fa.is_deterministic());
+	ASSERT_TRUE(r.is_one_unambiguous());
+	// b и c каждого блока склеиваются с d предыдущего (первого - с начальным)
+	ASSERT_EQ(r.to_ilieyu().size(), 2001);
+}
+
 TEST(TestGetOneUnambigous, GetOneUnambigousWorks) {
 	auto check_one_unambiguous = [](const string& rgx_str, bool expected_res) {
 		ASSERT_TRUE(Regex(rgx_str).get_one_unambiguous_regex().is_one_unambiguous() ==
@@ -728,6 +1074,178 @@ TEST(TestParsing, MFAParsing) {
 	});
 }
 
+TEST(TestParsing, FAParsing) {
+	using Test = std::tuple<string, string, bool>;
+	vector<Test> tests = {
+		{"(a*)*b", "aaab", true},
+		{"(a*)*b", string(1000, 'a'), false},
+		{"(a|aa)*b", string(999, 'a') + "b", true},
+		{"(a|b)*a(a|b)", "bbab", true},
+		{"(a|b)*a(a|b)", "bbba", false},
+		{"a*", "", true},
+		{"a*", "ac", false},
+	};
+
+	for_each(tests.begin(), tests.end(), [](const Test& test) {
+		auto [rgx_str, str, expected_res] = test;
+		SCOPED_TRACE("Regex: " + rgx_str);
+		Regex r(rgx_str);
+		ASSERT_EQ(r.to_thompson().parse(str).second, expected_res);
+		ASSERT_EQ(r.to_glushkov().parse(str).second, expected_res);
+		ASSERT_EQ(r.to_antimirov().parse(str).second, expected_res);
+	});
+	// число шагов линейно по длине слова: не больше |w| + 1 активаций каждого состояния
+	FiniteAutomaton fa = Regex("(a*)*b").to_thompson();
+	ASSERT_LE(fa.parse(string(1000, 'a')).first, 1001 * fa.size());
+	// без языка символы берутся из переходов автомата
+	FiniteAutomaton no_language(0, Regex("ab*").to_glushkov().get_states(), nullptr);
+	ASSERT_TRUE(no_language.parse("abb").second);
+	ASSERT_FALSE(no_language.parse("ba").second);
+}
+
+TEST(TestParsing, DFAMatcher) {
+	Regex r("(a|b)*a(a|b)");
+	DFAMatcher matcher(r.to_thompson());
+	DFAMatcher min_matcher(r.to_thompson().minimize());
+
+	// a и b различаются, все прочие байты ведут в ловушку
+	ASSERT_EQ(min_matcher.byte_classes_count(), 3);
+	ASSERT_EQ(min_matcher.states_count(), 5);
+	vector<std::string_view> words = {"ab", "bbaa", "", "ba", "abc", "a", "aab"};
+	vector<bool> expected = {true, true, false, false, false, false, true};
+	ASSERT_EQ(matcher.match(words), expected);
+	ASSERT_EQ(min_matcher.match(words), expected);
+	ASSERT_EQ(min_matcher.count_matches(words), 3);
+	ASSERT_TRUE(matcher.match(string(100000, 'b') + "ab"));
+}
+
+TEST(TestParsing, LazyDFAMatcher) {
+	Regex r("(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)");
+	FiniteAutomaton fa = r.to_thompson();
+	LazyDFAMatcher matcher(fa);
+	// лимит на несколько состояний заставляет сбрасывать кэш
+	LazyDFAMatcher small_matcher(fa, 1024);
+
+	vector<string> words;
+	for (int i = 0; i < 200; i++) {
+		string word;
+		for (int j = 0; j < i % 23; j++)
+			word += "ab"[(i * 7 + j * j) % 3 == 0];
+		words.push_back(word);
+	}
+	words.emplace_back("abc");
+	for (const string& word : words) {
+		SCOPED_TRACE("Word: " + word);
+		ASSERT_EQ(matcher.match(word), fa.parse(word).second);
+		ASSERT_EQ(small_matcher.match(word), fa.parse(word).second);
+	}
+	ASSERT_EQ(matcher.flushes_count(), 0);
+	ASSERT_GT(small_matcher.flushes_count(), 0);
+	ASSERT_LT(matcher.cached_states_count(), fa.determinize().size());
+}
+
+TEST(TestParsing, BitParallelMatcher) {
+	// 64 позиции с начальным состоянием не помещаются в одно слово
+	string long_regex = "(a|b)*a";
+	for (int i = 0; i < 70; i++)
+		long_regex += "(a|b)";
+	for (const string& rgx_str : {string("(a|b)*a(a|b)(a|b)"), string("(ab|a*c)*b*"), long_regex}) {
+		SCOPED_TRACE("Regex: " + rgx_str);
+		Regex r(rgx_str);
+		FiniteAutomaton fa = r.to_glushkov();
+		BitParallelMatcher matcher(r);
+		ASSERT_EQ(matcher.positions_count(), fa.size());
+		for (int i = 0; i < 300; i++) {
+			string word;
+			for (int j = 0; j < i % 97; j++)
+				word += "abc"[(i * 7 + j * j) % 5 % 3];
+			ASSERT_EQ(matcher.match(word), fa.parse(word).second);
+		}
+	}
+	ASSERT_GT(BitParallelMatcher(Regex(long_regex)).words_count(), 1);
+}
+
+TEST(TestParsing, StreamMatcher) {
+	FiniteAutomaton fa = Regex("(a|b)*a(a|b)(a|b)").to_thompson();
+	DFAMatcher dfa_matcher(fa);
+	DFAMatcher::Stream dfa_stream(dfa_matcher);
+	LazyDFAMatcher lazy_stream(fa);
+
+	for (StreamMatcher* stream : vector<StreamMatcher*>{&dfa_stream, &lazy_stream}) {
+		stream->reset();
+		ASSERT_TRUE(stream->feed("abba"));
+		ASSERT_TRUE(stream->feed(""));
+		ASSERT_TRUE(stream->feed("ab"));
+		ASSERT_TRUE(stream->finish());
+		ASSERT_EQ(stream->bytes_consumed(), 6);
+		ASSERT_TRUE(stream->feed("bb"));
+		ASSERT_FALSE(stream->finish());
+		// после недопустимого байта слово уже не может быть принято
+		ASSERT_FALSE(stream->feed("abcab"));
+		ASSERT_EQ(stream->bytes_consumed(), 11);
+		ASSERT_FALSE(stream->feed("aaa"));
+		ASSERT_FALSE(stream->finish());
+	}
+
+	// ловушка самого автомата распознаётся так же, как отсутствующий переход
+	FiniteAutomaton trap_fa = Regex("ab").to_glushkov().determinize();
+	DFAMatcher trap_matcher(trap_fa);
+	DFAMatcher::Stream trap_dfa_stream(trap_matcher);
+	LazyDFAMatcher trap_lazy_stream(trap_fa);
+	for (StreamMatcher* stream : vector<StreamMatcher*>{&trap_dfa_stream, &trap_lazy_stream}) {
+		stream->reset();
+		ASSERT_TRUE(stream->feed("ab"));
+		ASSERT_TRUE(stream->finish());
+		stream->reset();
+		ASSERT_FALSE(stream->feed("ba"));
+		ASSERT_EQ(stream->bytes_consumed(), 1);
+		ASSERT_FALSE(stream->finish());
+	}
+
+	std::filesystem::path path =
+		std::filesystem::temp_directory_path() / "stream_matcher_test.txt";
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << string(1 << 20, 'b') << "abb";
+	}
+	StreamMatcher::Result result = StreamMatcher::match_file(dfa_stream, path.string());
+	ASSERT_TRUE(result.accepted);
+	ASSERT_EQ(result.bytes_consumed, (1 << 20) + 3);
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << "abcabb";
+	}
+	result = StreamMatcher::match_file(lazy_stream, path.string());
+	ASSERT_FALSE(result.accepted);
+	ASSERT_EQ(result.bytes_consumed, 3);
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << "b" << string(1 << 20, 'a');
+	}
+	for (StreamMatcher* stream : vector<StreamMatcher*>{&trap_dfa_stream, &trap_lazy_stream}) {
+		result = StreamMatcher::match_file(*stream, path.string());
+		ASSERT_FALSE(result.accepted);
+		ASSERT_EQ(result.bytes_consumed, 1);
+	}
+	std::filesystem::remove(path);
+}
+
+TEST(TestParsing, MultiPatternMatcher) {
+	vector<Regex> patterns = {Regex("(a|b)*a"), Regex("a*"), Regex("(ab)*"), Regex("b(a|b)*c")};
+	MultiPatternMatcher matcher(patterns);
+	MultiPatternMatcher fa_matcher(
+		vector<FiniteAutomaton>{patterns[0].to_thompson(), patterns[3].to_antimirov()});
+
+	ASSERT_EQ(matcher.patterns_count(), 4);
+	ASSERT_EQ(matcher.match(""), vector<int>({1, 2}));
+	ASSERT_EQ(matcher.match("aa"), vector<int>({0, 1}));
+	ASSERT_EQ(matcher.match("abab"), vector<int>({2}));
+	ASSERT_EQ(matcher.match("bac"), vector<int>({3}));
+	ASSERT_EQ(matcher.match("cab"), vector<int>());
+	ASSERT_EQ(fa_matcher.match(vector<std::string_view>{"ba", "bbc", "b"}),
+			  vector<vector<int>>({{0}, {1}, {}}));
+}
+
 TEST(TestReverse, BRegex_Reverse) {
 	ASSERT_TRUE(BackRefRegex::equal(BackRefRegex("([a*b]:1&1|b&1)").reverse(),
 									BackRefRegex("[ba*]:1&1|&1b")));
@@ -735,6 +1253,47 @@ TEST(TestReverse, BRegex_Reverse) {
 			  "((b[ba*c]:1c)*b&1&1c)*(bc)*");
 }
 
+TEST(TestAmbiguity, PathCounter) {
+	// в автомате Томпсона без eps-переходов для (a|a|b|b)* слов длины k - 2^k, а путей - 4^k
+	PathCounter counter(Regex("(a|a|b|b)*").to_thompson().remove_eps());
+	InfInt expected = 1;
+	for (int k = 1; k <= 40; k++) {
+		expected *= 4;
+		ASSERT_EQ(counter.next(), expected);
+		// 4^32 уже не помещается в uint64_t
+		ASSERT_EQ(counter.is_using_big_integers(), k >= 32);
+	}
+}
+
+TEST(TestAmbiguity, InfIntArithmetic) {
+	// 3^2000 и 7^1500 - числа в десятки 64-битных разрядов: умножение идёт по Карацубе
+	InfInt a = 1, b = 1;
+	for (int i = 0; i < 2000; i++)
+		a *= 3;
+	for (int i = 0; i < 1500; i++)
+		b *= 7;
+	InfInt product = a * b, c = a + 12345;
+	ASSERT_EQ(product / b, a);
+	ASSERT_EQ(product % a, 0);
+	ASSERT_EQ((product + 5) % b, 5);
+	ASSERT_EQ(-(product + 5) / b, -a);
+	ASSERT_EQ(-(product + 5) % b, -5);
+	ASSERT_EQ(InfInt::gcd(a * 10, b * 14), 2);
+	ASSERT_EQ(InfInt::gcd(product, a * 2), a);
+	ASSERT_EQ(InfInt(c.toString()), c);
+	ASSERT_EQ(a.numberOfDigits(), 955);
+	ASSERT_EQ((a * a).intSqrt(), a);
+	ASSERT_EQ(InfInt("-18446744073709551616").toString(), "-18446744073709551616");
+
+	Fraction x(a * 6, b * 4), y(a * 3, b * 2);
+	ASSERT_TRUE(x == y);
+	Fraction::Context context;
+	ASSERT_TRUE(Fraction(3, 4).subtract(Fraction(2, 3), context) == Fraction(1, 12));
+	// 9 * 3 - 2 * 4 = 1 и 4 * 3 = 12
+	ASSERT_EQ(context.last_number_of_digits, 3);
+	ASSERT_TRUE(Fraction(1, 12) > Fraction());
+}
+
 TEST(TestAmbiguity, AmbiguityValues) {
 	enum AutomatonType {
 		thompson,
@@ -794,4 +1353,33 @@ TEST(TestAmbiguity, AmbiguityValues) {
 			break;
 		}
 	});
-}
\ No newline at end of file
+}
+
+TEST(TestAmbiguity, StructuralAmbiguityValues) {
+	using Test = std::tuple<string, FiniteAutomaton::AmbiguityValue>;
+	vector<Test> tests = {
+		// eps-циклы автомата Томпсона исчезают при удалении eps-переходов
+		{"(a*)*", FiniteAutomaton::unambigious},
+		{"a*a*", FiniteAutomaton::polynomially_ambigious},
+		{"abc", FiniteAutomaton::unambigious},
+		{"b|a", FiniteAutomaton::unambigious},
+		{"a|a", FiniteAutomaton::almost_unambigious},
+		{"(aa|aa)*", FiniteAutomaton::exponentially_ambiguous},
+		{"a*a*a*", FiniteAutomaton::polynomially_ambigious},
+		{"a*(b*)*", FiniteAutomaton::unambigious},
+		{"(aa|aa)(aa|bb)*|a(ba)*", FiniteAutomaton::almost_unambigious},
+		{"(a|)(ab|aaa|baa)*(a|)", FiniteAutomaton::almost_unambigious},
+		{"(ac*|ad*)*", FiniteAutomaton::exponentially_ambiguous},
+		{"(ab)*ab(ab)*", FiniteAutomaton::polynomially_ambigious},
+		{"(a|b)*a(a|b)*", FiniteAutomaton::polynomially_ambigious},
+		{"(abab)*abab(abab)*|(aac)*(aac)*", FiniteAutomaton::polynomially_ambigious},
+		{"((bb*c|c)c*b|bb*b|b)(b|(c|bb*c)c*b|bb*b)*", FiniteAutomaton::exponentially_ambiguous},
+		{"(a|b|c)*(a|b|c|d)(a|b|c)*|(ac*|ad*)*", FiniteAutomaton::exponentially_ambiguous},
+	};
+	for (const auto& [reg_string, expected_res] : tests) {
+		SCOPED_TRACE(reg_string);
+		for (const auto& fa : {Regex(reg_string).to_thompson(), Regex(reg_string).to_glushkov()}) {
+			ASSERT_EQ(fa.ambiguity(FiniteAutomaton::AmbiguityMode::structural), expected_res);
+		}
+	}
+}
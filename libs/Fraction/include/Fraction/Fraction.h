@@ -4,43 +4,56 @@
 #include "InfInt.h"
 
 class Fraction {
-	InfInt numerator;
-	InfInt denominator;
+	// дробь хранится с положительным знаменателем, но сокращается лениво - только перед
+	// сравнением, выводом и вычитанием с контекстом. Сокращение меняет поля и в константных
+	// методах, поэтому одну дробь из нескольких потоков можно читать только с внешней
+	// синхронизацией
+	mutable InfInt numerator;
+	mutable InfInt denominator;
+	mutable bool is_reduced;
 
   public:
-	inline static unsigned long long last_number_of_digits = 0;
+	// контекст вычислений: сведения о последней операции хранятся в нём, а не в статическом
+	// поле, поэтому разные дроби можно обрабатывать в разных потоках
+	struct Context {
+		// суммарное число цифр числителя и знаменателя разности до сокращения
+		unsigned long long last_number_of_digits = 0;
+	};
+
 	Fraction();
 	Fraction(InfInt n, InfInt d);
 	~Fraction();
-	Fraction operator+(const Fraction& f);
-	Fraction operator-(const Fraction& f);
-	Fraction operator*(const Fraction& f);
-	Fraction operator/(const Fraction& f);
+	Fraction operator+(const Fraction& f) const;
+	Fraction operator-(const Fraction& f) const;
+	Fraction operator*(const Fraction& f) const;
+	Fraction operator/(const Fraction& f) const;
 	Fraction operator+=(const Fraction& f);
 	Fraction operator++();
 	Fraction operator++(int);
-	bool operator>(const Fraction& f);
-	bool operator==(const Fraction& f);
-	bool operator>=(const Fraction& f);
+	bool operator>(const Fraction& f) const;
+	bool operator==(const Fraction& f) const;
+	bool operator>=(const Fraction& f) const;
+	// вычитание, записывающее размер несокращённого результата в контекст
+	Fraction subtract(const Fraction& f, Context& context) const; // NOLINT(runtime/references)
 	friend std::ostream& operator<<(std::ostream& output, const Fraction& f);
 
   private:
-	void simplify() {
-		reduction();
-		fix_sign();
-	}
 	void fix_sign() {
 		if (denominator < 0) {
 			denominator = -denominator;
 			numerator = -numerator;
 		}
 	}
-	void reduction() {
-		InfInt common = gcd(numerator, denominator);
-		numerator /= common;
-		denominator /= common;
-	}
-	InfInt gcd(InfInt x, InfInt y) {
-		return y == 0 ? x : gcd(y, x % y);
+	void reduction() const {
+		if (is_reduced)
+			return;
+		InfInt common = InfInt::gcd(numerator, denominator);
+		if (common != 1) {
+			numerator /= common;
+			denominator /= common;
+		}
+		is_reduced = true;
 	}
-};
\ No newline at end of file
+	// знак числителя разности *this - f
+	int compare(const Fraction& f) const;
+};
@@ -17,6 +17,7 @@
  *      numberOfDigits: returns number of digits
  *      size:           returns size in bytes
  *      toString:       converts it to a string
+ *      gcd:            greatest common divisor of absolute values
  *
  *   There are also conversion methods which allow conversion to primitive
  * types: toInt, toLong, toLongLong, toUnsignedInt, toUnsignedLong,
@@ -26,6 +27,12 @@
  *   InfIntException in case of error instead of writing error messages using
  *   std::cerr.
  *
+ *   The magnitude is stored in binary: 64-bit limbs, least significant first,
+ * with 128-bit intermediate products. Multiplication switches to Karatsuba
+ * above KARATSUBA_THRESHOLD limbs, division is Knuth's algorithm D and gcd
+ * is Lehmer's algorithm finished by binary gcd on single limbs. Decimal form
+ * is only computed for printing and digit queries.
+ *
  *   See ReadMe.txt for more info.
  *
  *
@@ -36,16 +43,16 @@
 #ifndef LIBS_FRACTION_INCLUDE_FRACTION_INFINT_H_
 #define LIBS_FRACTION_INCLUDE_FRACTION_INFINT_H_
 
+#include <algorithm>
 #include <climits>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
-// #include <limits.h>
-// #include <stdlib.h>
-
 #ifdef _WIN32
 #define LONG_LONG_MIN LLONG_MIN
 #define LONG_LONG_MAX LLONG_MAX
@@ -61,13 +68,6 @@ using std::endl;
 using std::string;
 using std::vector;
 
-typedef int ELEM_TYPE;
-typedef long long PRODUCT_TYPE;
-static const ELEM_TYPE BASE = 1000000000;
-static const ELEM_TYPE UPPER_BOUND = 999999999;
-static const ELEM_TYPE DIGIT_COUNT = 9;
-static const int powersOfTen[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
-
 #ifdef INFINT_USE_EXCEPTIONS
 class InfIntException : public std::exception {
   public:
@@ -88,27 +88,394 @@ inline const char* InfIntException::what() const throw() {
 }
 #endif
 
-inline static div_t my_div(int num, int denom) {
-	div_t result;
-	result.quot = num / denom;
-	result.rem = num - denom * result.quot;
-	return result;
+/* operations on magnitudes: little-endian limb arrays */
+namespace infint_detail {
+typedef uint64_t limb;
+
+static const size_t KARATSUBA_THRESHOLD = 32;
+/* the largest power of ten that fits in a limb */
+static const limb DECIMAL_BASE = 10000000000000000000ULL;
+static const int DECIMAL_DIGITS = 19;
+
+inline int countLeadingZeros(limb x) { // x != 0
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_clzll(x);
+#else
+	int n = 0;
+	for (limb bit = limb(1) << 63; !(x & bit); bit >>= 1)
+		n++;
+	return n;
+#endif
 }
 
-inline static ldiv_t my_ldiv(long num, long denom) {
-	ldiv_t result;
-	result.quot = num / denom;
-	result.rem = num - denom * result.quot;
-	return result;
+inline int countTrailingZeros(limb x) { // x != 0
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(x);
+#else
+	int n = 0;
+	for (; !(x & 1); x >>= 1)
+		n++;
+	return n;
+#endif
+}
+
+/* low limb of a * b, the high one goes to hi */
+inline limb mulWide(limb a, limb b, limb& hi) { // NOLINT(runtime/references)
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 p = static_cast<unsigned __int128>(a) * b;
+	hi = static_cast<limb>(p >> 64);
+	return static_cast<limb>(p);
+#else
+	limb a0 = a & 0xffffffff, a1 = a >> 32, b0 = b & 0xffffffff, b1 = b >> 32;
+	limb p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+	limb middle = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+	hi = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32);
+	return (middle << 32) | (p00 & 0xffffffff);
+#endif
+}
+
+/* (hi * 2^64 + lo) / d for hi < d, the remainder goes to rem */
+inline limb divWide(limb hi, limb lo, limb d, limb& rem) { // NOLINT(runtime/references)
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 n = (static_cast<unsigned __int128>(hi) << 64) | lo;
+	rem = static_cast<limb>(n % d);
+	return static_cast<limb>(n / d);
+#else
+	/* two steps of schoolbook division by 32-bit halves of the normalized divisor */
+	const limb b = limb(1) << 32;
+	int s = countLeadingZeros(d);
+	d <<= s;
+	limb vn1 = d >> 32, vn0 = d & 0xffffffff;
+	limb un32 = s ? (hi << s) | (lo >> (64 - s)) : hi;
+	limb un10 = lo << s;
+	limb un1 = un10 >> 32, un0 = un10 & 0xffffffff;
+	limb q1 = un32 / vn1, rhat = un32 - q1 * vn1;
+	while (q1 >= b || q1 * vn0 > b * rhat + un1) {
+		q1--;
+		rhat += vn1;
+		if (rhat >= b)
+			break;
+	}
+	limb un21 = un32 * b + un1 - q1 * d;
+	limb q0 = un21 / vn1;
+	rhat = un21 - q0 * vn1;
+	while (q0 >= b || q0 * vn0 > b * rhat + un0) {
+		q0--;
+		rhat += vn1;
+		if (rhat >= b)
+			break;
+	}
+	rem = (un21 * b + un0 - q0 * d) >> s;
+	return q1 * b + q0;
+#endif
+}
+
+inline void trim(vector<limb>& x) { // NOLINT(runtime/references)
+	while (!x.empty() && x.back() == 0)
+		x.pop_back();
+}
+
+inline int compare(const limb* a, size_t na, const limb* b, size_t nb) {
+	if (na != nb)
+		return na < nb ? -1 : 1;
+	for (size_t i = na; i-- > 0;)
+		if (a[i] != b[i])
+			return a[i] < b[i] ? -1 : 1;
+	return 0;
+}
+
+inline int compare(const vector<limb>& a, const vector<limb>& b) {
+	return compare(a.data(), a.size(), b.data(), b.size());
+}
+
+/* x[0, nx) += y[0, ny) for nx >= ny, returns carry */
+inline limb addTo(limb* x, size_t nx, const limb* y, size_t ny) {
+	limb carry = 0;
+	size_t i = 0;
+	for (; i < ny; i++) {
+		limb s = x[i] + carry;
+		carry = s < carry;
+		s += y[i];
+		carry += s < y[i];
+		x[i] = s;
+	}
+	for (; carry && i < nx; i++)
+		carry = ++x[i] == 0;
+	return carry;
+}
+
+/* x[0, nx) -= y[0, ny) for nx >= ny, returns borrow */
+inline limb subtractFrom(limb* x, size_t nx, const limb* y, size_t ny) {
+	limb borrow = 0;
+	size_t i = 0;
+	for (; i < ny; i++) {
+		limb d = x[i] - y[i];
+		limb b = x[i] < y[i];
+		b += d < borrow;
+		x[i] = d - borrow;
+		borrow = b;
+	}
+	for (; borrow && i < nx; i++)
+		borrow = x[i]-- == 0;
+	return borrow;
+}
+
+inline void addAbs(vector<limb>& x, const vector<limb>& y) { // NOLINT(runtime/references)
+	if (x.size() < y.size())
+		x.resize(y.size(), 0);
+	if (addTo(x.data(), x.size(), y.data(), y.size()))
+		x.push_back(1);
+}
+
+/* x -= y for x >= y */
+inline void subtractAbs(vector<limb>& x, const vector<limb>& y) { // NOLINT(runtime/references)
+	subtractFrom(x.data(), x.size(), y.data(), y.size());
+	trim(x);
+}
+
+/* x = x * m + a */
+inline void multiplyAddSmall(vector<limb>& x, limb m, limb a) { // NOLINT(runtime/references)
+	if (m == 0)
+		x.clear();
+	limb carry = a;
+	for (limb& l : x) {
+		limb hi;
+		limb lo = mulWide(l, m, hi) + carry;
+		hi += lo < carry;
+		l = lo;
+		carry = hi;
+	}
+	if (carry)
+		x.push_back(carry);
+}
+
+/* x /= d, returns remainder */
+inline limb divideSmall(vector<limb>& x, limb d) { // NOLINT(runtime/references)
+	limb rem = 0;
+	for (size_t i = x.size(); i-- > 0;)
+		x[i] = divWide(rem, x[i], d, rem);
+	trim(x);
+	return rem;
+}
+
+/* r[0, na + nb) = a * b */
+inline void multiplySchool(const limb* a, size_t na, const limb* b, size_t nb, limb* r) {
+	std::fill(r, r + na + nb, 0);
+	for (size_t i = 0; i < na; i++) {
+		limb carry = 0;
+		for (size_t j = 0; j < nb; j++) {
+			limb hi;
+			limb lo = mulWide(a[i], b[j], hi) + carry;
+			hi += lo < carry;
+			lo += r[i + j];
+			hi += lo < r[i + j];
+			r[i + j] = lo;
+			carry = hi;
+		}
+		r[i + nb] = carry;
+	}
 }
 
-inline static lldiv_t my_lldiv(long long num, long long denom) {
-	lldiv_t result;
-	result.quot = num / denom;
-	result.rem = num - denom * result.quot;
+/* r[0, na + nb) = a * b */
+inline void multiply(const limb* a, size_t na, const limb* b, size_t nb, limb* r) {
+	if (na < nb) {
+		std::swap(a, b);
+		std::swap(na, nb);
+	}
+	if (nb < KARATSUBA_THRESHOLD) {
+		multiplySchool(a, na, b, nb, r);
+		return;
+	}
+	std::fill(r, r + na + nb, 0);
+	if (2 * nb <= na) {
+		/* unbalanced operands: a is cut into pieces of the length of b */
+		vector<limb> piece(2 * nb);
+		for (size_t i = 0; i < na; i += nb) {
+			size_t n = std::min(nb, na - i);
+			multiply(a + i, n, b, nb, piece.data());
+			addTo(r + i, na + nb - i, piece.data(), n + nb);
+		}
+		return;
+	}
+	/* Karatsuba: a = a1 * B^m + a0, b = b1 * B^m + b0 */
+	size_t m = na / 2;
+	multiply(a, m, b, m, r);
+	multiply(a + m, na - m, b + m, nb - m, r + 2 * m);
+	vector<limb> sa(a + m, a + na), sb(b + m, b + nb);
+	sb.resize(std::max(sb.size(), m), 0);
+	sa.push_back(addTo(sa.data(), sa.size(), a, m));
+	sb.push_back(addTo(sb.data(), sb.size(), b, m));
+	vector<limb> middle(sa.size() + sb.size());
+	multiply(sa.data(), sa.size(), sb.data(), sb.size(), middle.data());
+	/* a0 * b0 and a1 * b1 are not longer than the middle product without its leading zeros */
+	trim(middle);
+	size_t n0 = 2 * m, n2 = na + nb - 2 * m;
+	while (n0 && r[n0 - 1] == 0)
+		n0--;
+	while (n2 && r[2 * m + n2 - 1] == 0)
+		n2--;
+	subtractFrom(middle.data(), middle.size(), r, n0);
+	subtractFrom(middle.data(), middle.size(), r + 2 * m, n2);
+	trim(middle);
+	addTo(r + m, na + nb - m, middle.data(), middle.size());
+}
+
+/* quotient and remainder of magnitudes (Knuth, algorithm D) */
+inline void divide(const vector<limb>& u, const vector<limb>& v, vector<limb>* q,
+				   vector<limb>* r) {
+	if (compare(u, v) < 0) {
+		if (r)
+			*r = u;
+		if (q)
+			q->clear();
+		return;
+	}
+	if (v.size() == 1) {
+		vector<limb> quotient = u;
+		limb rem = divideSmall(quotient, v[0]);
+		if (q)
+			q->swap(quotient);
+		if (r) {
+			r->clear();
+			if (rem)
+				r->push_back(rem);
+		}
+		return;
+	}
+	size_t n = v.size(), m = u.size() - n;
+	int s = countLeadingZeros(v.back());
+	vector<limb> vn(n), un(u.size() + 1);
+	for (size_t i = n; i-- > 0;)
+		vn[i] = (v[i] << s) | (s && i ? v[i - 1] >> (64 - s) : 0);
+	un[u.size()] = s ? u.back() >> (64 - s) : 0;
+	for (size_t i = u.size(); i-- > 0;)
+		un[i] = (u[i] << s) | (s && i ? u[i - 1] >> (64 - s) : 0);
+	vector<limb> quotient(m + 1);
+	for (size_t j = m + 1; j-- > 0;) {
+		limb qhat, rhat;
+		bool rhat_overflow = false;
+		if (un[j + n] >= vn[n - 1]) {
+			qhat = ~limb(0);
+			rhat = un[j + n - 1] + vn[n - 1];
+			rhat_overflow = rhat < vn[n - 1];
+		} else {
+			qhat = divWide(un[j + n], un[j + n - 1], vn[n - 1], rhat);
+		}
+		while (!rhat_overflow) {
+			limb hi;
+			limb lo = mulWide(qhat, vn[n - 2], hi);
+			if (hi < rhat || (hi == rhat && lo <= un[j + n - 2]))
+				break;
+			qhat--;
+			rhat += vn[n - 1];
+			rhat_overflow = rhat < vn[n - 1];
+		}
+		limb borrow = 0, carry = 0;
+		for (size_t i = 0; i < n; i++) {
+			limb hi;
+			limb lo = mulWide(qhat, vn[i], hi) + carry;
+			hi += lo < carry;
+			carry = hi;
+			limb d = un[i + j] - lo;
+			limb b = un[i + j] < lo;
+			b += d < borrow;
+			un[i + j] = d - borrow;
+			borrow = b;
+		}
+		limb d = un[j + n] - carry;
+		limb b = un[j + n] < carry;
+		b += d < borrow;
+		un[j + n] = d - borrow;
+		if (b) {
+			qhat--;
+			un[j + n] += addTo(un.data() + j, n, vn.data(), n);
+		}
+		quotient[j] = qhat;
+	}
+	if (q) {
+		trim(quotient);
+		q->swap(quotient);
+	}
+	if (r) {
+		r->resize(n);
+		for (size_t i = 0; i < n; i++)
+			(*r)[i] = s ? (un[i] >> s) | (un[i + 1] << (64 - s)) : un[i];
+		trim(*r);
+	}
+}
+
+inline limb gcdSmall(limb a, limb b) {
+	if (a == 0)
+		return b;
+	if (b == 0)
+		return a;
+	int shift = countTrailingZeros(a | b);
+	a >>= countTrailingZeros(a);
+	while (b) {
+		b >>= countTrailingZeros(b);
+		if (a > b)
+			std::swap(a, b);
+		b -= a;
+	}
+	return a << shift;
+}
+
+/* x * a - y * b for x * a >= y * b */
+inline vector<limb> combine(const vector<limb>& a, limb x, const vector<limb>& b, limb y) {
+	vector<limb> result = a, subtrahend = b;
+	multiplyAddSmall(result, x, 0);
+	multiplyAddSmall(subtrahend, y, 0);
+	subtractAbs(result, subtrahend);
 	return result;
 }
 
+/* gcd of magnitudes (Lehmer): while both numbers are long, Euclid steps are simulated on
+ * their leading 62 bits and applied to the full numbers as a single linear combination */
+inline vector<limb> gcd(vector<limb> a, vector<limb> b) {
+	if (compare(a, b) < 0)
+		a.swap(b);
+	vector<limb> remainder;
+	while (b.size() > 1) {
+		int64_t x0 = 1, y0 = 0, x1 = 0, y1 = 1;
+		if (a.size() == b.size()) {
+			size_t n = a.size();
+			int s = countLeadingZeros(a[n - 1]);
+			int64_t ah = ((a[n - 1] << s) | (s ? a[n - 2] >> (64 - s) : 0)) >> 2;
+			int64_t bh = ((b[n - 1] << s) | (s ? b[n - 2] >> (64 - s) : 0)) >> 2;
+			while (bh + x1 > 0 && bh + y1 > 0 && ah + x0 >= 0 && ah + y0 >= 0) {
+				int64_t q = (ah + x0) / (bh + x1);
+				if (q != (ah + y0) / (bh + y1))
+					break;
+				int64_t t = x0 - q * x1;
+				x0 = x1;
+				x1 = t;
+				t = y0 - q * y1;
+				y0 = y1;
+				y1 = t;
+				t = ah - q * bh;
+				ah = bh;
+				bh = t;
+			}
+		}
+		if (y0 == 0) {
+			divide(a, b, nullptr, &remainder);
+			a.swap(b);
+			b.swap(remainder);
+			continue;
+		}
+		/* the cofactors of each row have opposite signs */
+		vector<limb> new_a = y0 <= 0 ? combine(a, x0, b, -y0) : combine(b, y0, a, -x0);
+		vector<limb> new_b = y1 <= 0 ? combine(a, x1, b, -y1) : combine(b, y1, a, -x1);
+		a.swap(new_a);
+		b.swap(new_b);
+	}
+	if (b.empty())
+		return a;
+	limb d = gcdSmall(b[0], divideSmall(a, b[0]));
+	return vector<limb>(1, d);
+}
+} // namespace infint_detail
+
 class InfInt {
 	friend std::ostream& operator<<(std::ostream& s, const InfInt& n);
 	friend std::istream& operator>>(std::istream& s, InfInt& val);
@@ -125,6 +492,7 @@ class InfInt {
 	InfInt(unsigned long l);	  // NOLINT(runtime/explicit)
 	InfInt(unsigned long long l); // NOLINT(runtime/explicit)
 	InfInt(const InfInt& l);
+	InfInt(InfInt&& l) noexcept;
 
 	/* assignment operators */
 	const InfInt& operator=(const char* c);
@@ -136,6 +504,7 @@ class InfInt {
 	const InfInt& operator=(unsigned long l);
 	const InfInt& operator=(unsigned long long l);
 	const InfInt& operator=(const InfInt& l);
+	const InfInt& operator=(InfInt&& l) noexcept;
 
 	/* unary increment/decrement operators */
 	const InfInt& operator++();
@@ -149,7 +518,7 @@ class InfInt {
 	const InfInt& operator*=(const InfInt& rhs);
 	const InfInt& operator/=(const InfInt& rhs); // throw
 	const InfInt& operator%=(const InfInt& rhs); // throw
-	const InfInt& operator*=(ELEM_TYPE rhs);
+	const InfInt& operator*=(int rhs);
 
 	/* operations */
 	InfInt operator-() const;
@@ -158,7 +527,7 @@ class InfInt {
 	InfInt operator*(const InfInt& rhs) const;
 	InfInt operator/(const InfInt& rhs) const; // throw
 	InfInt operator%(const InfInt& rhs) const; // throw
-	InfInt operator*(ELEM_TYPE rhs) const;
+	InfInt operator*(int rhs) const;
 
 	/* relational operations */
 	bool operator==(const InfInt& rhs) const;
@@ -171,6 +540,9 @@ class InfInt {
 	/* integer square root */
 	InfInt intSqrt() const; // throw
 
+	/* greatest common divisor of absolute values, gcd(0, 0) = 0 */
+	static InfInt gcd(const InfInt& a, const InfInt& b);
+
 	/* digit operations */
 	char digitAt(size_t i) const; // throw
 	size_t numberOfDigits() const;
@@ -190,641 +562,258 @@ class InfInt {
 	unsigned long long toUnsignedLongLong() const; // throw
 
   private:
-	static ELEM_TYPE dInR(const InfInt& R, const InfInt& D);
-	static void multiplyByDigit(ELEM_TYPE factor,
-								vector<ELEM_TYPE>& val); // NOLINT(runtime/references)
+	typedef infint_detail::limb limb;
 
-	void correct(bool justCheckLeadingZeros = false, bool hasValidSign = false);
+	void assign(unsigned long long magnitude, bool positive);
+	void add(const InfInt& rhs, bool rhsPos);
 	void fromString(const string& s);
-	void optimizeSqrtSearchBounds(InfInt& lo, InfInt& hi) const; // NOLINT(runtime/references)
-	void truncateToBase();
-	bool equalizeSigns();
-	void removeLeadingZeros();
-
-	vector<ELEM_TYPE> val; // number with base FACTOR
-	bool pos;			   // true if number is positive
+	bool divisionByZero(const InfInt& rhs) const;
+	static void divide(const InfInt& n, const InfInt& d, InfInt* q, InfInt* r);
+	/* decimal chunks of 19 digits, least significant first */
+	vector<limb> toDecimal() const;
+	/* low limb of the magnitude with the sign applied modulo 2^64 */
+	unsigned long long lowBits() const;
+
+	vector<limb> val; // magnitude, least significant limb first, no leading zero limbs
+	bool pos;		  // true if number is positive or zero
 };
 
-inline InfInt::InfInt() : pos(true) {
-	// PROFINY_SCOPE
-	val.push_back((ELEM_TYPE)0);
-}
+inline InfInt::InfInt() : pos(true) {}
 
 inline InfInt::InfInt(const char* c) {
-	// PROFINY_SCOPE
 	fromString(c);
 }
 
 inline InfInt::InfInt(const string& s) {
-	// PROFINY_SCOPE
 	fromString(s);
 }
 
-inline InfInt::InfInt(int l) : pos(l >= 0) {
-	// PROFINY_SCOPE
-	bool subtractOne = false;
-	if (l == INT_MIN) {
-		subtractOne = true;
-		++l;
-	}
-
-	if (!pos) {
-		l = -l;
-	}
-	do {
-		div_t dt = my_div(l, BASE);
-		val.push_back((ELEM_TYPE)dt.rem);
-		l = dt.quot;
-	} while (l > 0);
-
-	if (subtractOne) {
-		--*this;
-	}
-}
-
-inline InfInt::InfInt(long l) : pos(l >= 0) {
-	// PROFINY_SCOPE
-	bool subtractOne = false;
-	if (l == LONG_MIN) {
-		subtractOne = true;
-		++l;
-	}
+inline InfInt::InfInt(int l) : InfInt(static_cast<long long>(l)) {}
 
-	if (!pos) {
-		l = -l;
-	}
-	do {
-		ldiv_t dt = my_ldiv(l, BASE);
-		val.push_back((ELEM_TYPE)dt.rem);
-		l = dt.quot;
-	} while (l > 0);
+inline InfInt::InfInt(long l) : InfInt(static_cast<long long>(l)) {}
 
-	if (subtractOne) {
-		--*this;
-	}
+inline InfInt::InfInt(long long l) {
+	assign(l < 0 ? 0ULL - static_cast<unsigned long long>(l) : l, l >= 0);
 }
 
-inline InfInt::InfInt(long long l) : pos(l >= 0) {
-	// PROFINY_SCOPE
-	bool subtractOne = false;
-	if (l == LONG_LONG_MIN) {
-		subtractOne = true;
-		++l;
-	}
-
-	if (!pos) {
-		l = -l;
-	}
-	do {
-		lldiv_t dt = my_lldiv(l, BASE);
-		val.push_back((ELEM_TYPE)dt.rem);
-		l = dt.quot;
-	} while (l > 0);
-
-	if (subtractOne) {
-		--*this;
-	}
+inline InfInt::InfInt(unsigned int l) {
+	assign(l, true);
 }
 
-inline InfInt::InfInt(unsigned int l) : pos(true) {
-	// PROFINY_SCOPE
-	do {
-		val.push_back((ELEM_TYPE)(l % BASE));
-		l = l / BASE;
-	} while (l > 0);
+inline InfInt::InfInt(unsigned long l) {
+	assign(l, true);
 }
 
-inline InfInt::InfInt(unsigned long l) : pos(true) {
-	// PROFINY_SCOPE
-	do {
-		val.push_back((ELEM_TYPE)(l % BASE));
-		l = l / BASE;
-	} while (l > 0);
+inline InfInt::InfInt(unsigned long long l) {
+	assign(l, true);
 }
 
-inline InfInt::InfInt(unsigned long long l) : pos(true) {
-	// PROFINY_SCOPE
-	do {
-		val.push_back((ELEM_TYPE)(l % BASE));
-		l = l / BASE;
-	} while (l > 0);
-}
+inline InfInt::InfInt(const InfInt& l) : val(l.val), pos(l.pos) {}
 
-inline InfInt::InfInt(const InfInt& l) : pos(l.pos), val(l.val) {
-	// PROFINY_SCOPE
+inline InfInt::InfInt(InfInt&& l) noexcept : val(std::move(l.val)), pos(l.pos) {
+	l.pos = true;
 }
 
 inline const InfInt& InfInt::operator=(const char* c) {
-	// PROFINY_SCOPE
 	fromString(c);
 	return *this;
 }
 
 inline const InfInt& InfInt::operator=(const string& s) {
-	// PROFINY_SCOPE
 	fromString(s);
 	return *this;
 }
 
 inline const InfInt& InfInt::operator=(int l) {
-	// PROFINY_SCOPE
-	bool subtractOne = false;
-	if (l == INT_MIN) {
-		subtractOne = true;
-		++l;
-	}
-
-	pos = l >= 0;
-	val.clear();
-	if (!pos) {
-		l = -l;
-	}
-	do {
-		div_t dt = my_div(l, BASE);
-		val.push_back((ELEM_TYPE)dt.rem);
-		l = dt.quot;
-	} while (l > 0);
-
-	return subtractOne ? --*this : *this;
+	return *this = static_cast<long long>(l);
 }
 
 inline const InfInt& InfInt::operator=(long l) {
-	// PROFINY_SCOPE
-	bool subtractOne = false;
-	if (l == LONG_MIN) {
-		subtractOne = true;
-		++l;
-	}
-
-	pos = l >= 0;
-	val.clear();
-	if (!pos) {
-		l = -l;
-	}
-	do {
-		ldiv_t dt = my_ldiv(l, BASE);
-		val.push_back((ELEM_TYPE)dt.rem);
-		l = dt.quot;
-	} while (l > 0);
-
-	return subtractOne ? --*this : *this;
+	return *this = static_cast<long long>(l);
 }
 
 inline const InfInt& InfInt::operator=(long long l) {
-	// PROFINY_SCOPE
-	bool subtractOne = false;
-	if (l == LONG_LONG_MIN) {
-		subtractOne = true;
-		++l;
-	}
-
-	pos = l >= 0;
-	val.clear();
-	if (!pos) {
-		l = -l;
-	}
-	do {
-		lldiv_t dt = my_lldiv(l, BASE);
-		val.push_back((ELEM_TYPE)dt.rem);
-		l = dt.quot;
-	} while (l > 0);
-
-	return subtractOne ? --*this : *this;
+	assign(l < 0 ? 0ULL - static_cast<unsigned long long>(l) : l, l >= 0);
+	return *this;
 }
 
 inline const InfInt& InfInt::operator=(unsigned int l) {
-	// PROFINY_SCOPE
-	pos = true;
-	val.clear();
-	do {
-		val.push_back((ELEM_TYPE)(l % BASE));
-		l = l / BASE;
-	} while (l > 0);
+	assign(l, true);
 	return *this;
 }
 
 inline const InfInt& InfInt::operator=(unsigned long l) {
-	// PROFINY_SCOPE
-	pos = true;
-	val.clear();
-	do {
-		val.push_back((ELEM_TYPE)(l % BASE));
-		l = l / BASE;
-	} while (l > 0);
+	assign(l, true);
 	return *this;
 }
 
 inline const InfInt& InfInt::operator=(unsigned long long l) {
-	// PROFINY_SCOPE
-	pos = true;
-	val.clear();
-	do {
-		val.push_back((ELEM_TYPE)(l % BASE));
-		l = l / BASE;
-	} while (l > 0);
+	assign(l, true);
 	return *this;
 }
 
 inline const InfInt& InfInt::operator=(const InfInt& l) {
-	// PROFINY_SCOPE
-	pos = l.pos;
 	val = l.val;
+	pos = l.pos;
 	return *this;
 }
 
-inline const InfInt& InfInt::operator++() {
-	// PROFINY_SCOPE
-	val[0] += (pos ? 1 : -1);
-	this->correct(false, true);
+inline const InfInt& InfInt::operator=(InfInt&& l) noexcept {
+	val.swap(l.val);
+	pos = l.pos;
 	return *this;
 }
 
+inline const InfInt& InfInt::operator++() {
+	return *this += 1;
+}
+
 inline const InfInt& InfInt::operator--() {
-	// PROFINY_SCOPE
-	val[0] -= (pos ? 1 : -1);
-	this->correct(false, true);
-	return *this;
+	return *this -= 1;
 }
 
 inline InfInt InfInt::operator++(int) {
-	// PROFINY_SCOPE
 	InfInt result = *this;
-	val[0] += (pos ? 1 : -1);
-	this->correct(false, true);
+	++*this;
 	return result;
 }
 
 inline InfInt InfInt::operator--(int) {
-	// PROFINY_SCOPE
 	InfInt result = *this;
-	val[0] -= (pos ? 1 : -1);
-	this->correct(false, true);
+	--*this;
 	return result;
 }
 
 inline const InfInt& InfInt::operator+=(const InfInt& rhs) {
-	// PROFINY_SCOPE
-	if (rhs.val.size() > val.size()) {
-		val.resize(rhs.val.size(), 0);
-	}
-	for (size_t i = 0; i < val.size(); ++i) {
-		val[i] = (pos ? val[i] : -val[i]) +
-				 (i < rhs.val.size() ? (rhs.pos ? rhs.val[i] : -rhs.val[i]) : 0);
-	}
-	correct();
+	add(rhs, rhs.pos);
 	return *this;
 }
 
 inline const InfInt& InfInt::operator-=(const InfInt& rhs) {
-	// PROFINY_SCOPE
-	if (rhs.val.size() > val.size()) {
-		val.resize(rhs.val.size(), 0);
-	}
-	for (size_t i = 0; i < val.size(); ++i) {
-		val[i] = (pos ? val[i] : -val[i]) -
-				 (i < rhs.val.size() ? (rhs.pos ? rhs.val[i] : -rhs.val[i]) : 0);
-	}
-	correct();
+	add(rhs, !rhs.pos || rhs.val.empty());
 	return *this;
 }
 
 inline const InfInt& InfInt::operator*=(const InfInt& rhs) {
-	// PROFINY_SCOPE
-	//  TODO: optimize (do not use operator*)
-	*this = *this * rhs;
+	if (val.empty() || rhs.val.empty()) {
+		*this = 0;
+		return *this;
+	}
+	if (rhs.val.size() == 1) {
+		infint_detail::multiplyAddSmall(val, rhs.val[0], 0);
+	} else {
+		vector<limb> product(val.size() + rhs.val.size());
+		infint_detail::multiply(
+			val.data(), val.size(), rhs.val.data(), rhs.val.size(), product.data());
+		infint_detail::trim(product);
+		val.swap(product);
+	}
+	pos = pos == rhs.pos;
 	return *this;
 }
 
 inline const InfInt& InfInt::operator/=(const InfInt& rhs) {
-	// PROFINY_SCOPE
-	if (rhs == 0) {
-#ifdef INFINT_USE_EXCEPTIONS
-		throw InfIntException("division by zero");
-#else
-		std::cerr << "Division by zero!" << endl;
+	if (divisionByZero(rhs))
 		return *this;
-#endif
-	}
-	InfInt R, D = (rhs.pos ? rhs : -rhs), N = (pos ? *this : -*this);
-	bool oldpos = pos;
-	std::fill(val.begin(), val.end(), 0);
-	for (int i = (int)N.val.size() - 1; i >= 0; --i) {
-		R.val.insert(R.val.begin(), N.val[i]);
-		R.correct(true);
-		ELEM_TYPE cnt = dInR(R, D);
-		R -= D * cnt;
-		val[i] += cnt;
-	}
-	correct();
-	pos = (val.size() == 1 && val[0] == 0) ? true : (oldpos == rhs.pos);
+	divide(*this, rhs, this, nullptr);
 	return *this;
 }
 
 inline const InfInt& InfInt::operator%=(const InfInt& rhs) {
-	// PROFINY_SCOPE
-	//  TODO: optimize (do not use operator%)
-	*this = *this % rhs;
+	if (divisionByZero(rhs))
+		return *this;
+	divide(*this, rhs, nullptr, this);
 	return *this;
-	//    if (rhs == 0)
-	//    {
-	// #ifdef INFINT_USE_EXCEPTIONS
-	//        throw InfIntException("division by zero");
-	// #else
-	//        std::cerr << "Division by zero!" << endl;
-	//        return *this;
-	// #endif
-	//    }
-	//    InfInt D = (rhs.pos ? rhs : -rhs), N = (pos ? *this : -*this);
-	//    bool oldpos = pos;
-	//    val.clear();
-	//    for (int i = (int) N.val.size() - 1; i >= 0; --i)
-	//    {
-	//        val.insert(val.begin(), N.val[i]);
-	//        correct(true);
-	//        *this -= D * dInR(*this, D);
-	//    }
-	//    correct();
-	//    pos = (val.size() == 1 && val[0] == 0) ? true : oldpos;
-	//    return *this;
-}
-
-inline const InfInt& InfInt::operator*=(ELEM_TYPE rhs) {
-	// PROFINY_SCOPE
-	ELEM_TYPE factor = rhs < 0 ? -rhs : rhs;
-	bool oldpos = pos;
-	multiplyByDigit(factor, val);
-	correct();
-	pos = (val.size() == 1 && val[0] == 0) ? true : (oldpos == (rhs >= 0));
+}
+
+inline const InfInt& InfInt::operator*=(int rhs) {
+	bool rhsPos = rhs >= 0;
+	infint_detail::multiplyAddSmall(
+		val, rhsPos ? rhs : 0ULL - static_cast<unsigned long long>(rhs), 0);
+	pos = val.empty() || pos == rhsPos;
 	return *this;
 }
 
 inline InfInt InfInt::operator-() const {
-	// PROFINY_SCOPE
 	InfInt result = *this;
-	result.pos = !pos;
+	result.pos = !pos || val.empty();
 	return result;
 }
 
 inline InfInt InfInt::operator+(const InfInt& rhs) const {
-	// PROFINY_SCOPE
-	InfInt result;
-	result.val.resize(val.size() > rhs.val.size() ? val.size() : rhs.val.size(), 0);
-	for (size_t i = 0; i < val.size() || i < rhs.val.size(); ++i) {
-		result.val[i] = (i < val.size() ? (pos ? val[i] : -val[i]) : 0) +
-						(i < rhs.val.size() ? (rhs.pos ? rhs.val[i] : -rhs.val[i]) : 0);
-	}
-	result.correct();
+	InfInt result = *this;
+	result += rhs;
 	return result;
 }
 
 inline InfInt InfInt::operator-(const InfInt& rhs) const {
-	// PROFINY_SCOPE
-	InfInt result;
-	result.val.resize(val.size() > rhs.val.size() ? val.size() : rhs.val.size(), 0);
-	for (size_t i = 0; i < val.size() || i < rhs.val.size(); ++i) {
-		result.val[i] = (i < val.size() ? (pos ? val[i] : -val[i]) : 0) -
-						(i < rhs.val.size() ? (rhs.pos ? rhs.val[i] : -rhs.val[i]) : 0);
-	}
-	result.correct();
+	InfInt result = *this;
+	result -= rhs;
 	return result;
 }
 
 inline InfInt InfInt::operator*(const InfInt& rhs) const {
-	// PROFINY_SCOPE
 	InfInt result;
-	result.val.resize(val.size() + rhs.val.size(), 0);
-	PRODUCT_TYPE carry = 0;
-	size_t digit = 0;
-	for (;; ++digit) {
-		lldiv_t dt = my_lldiv(carry, BASE);
-		carry = dt.quot;
-		result.val[digit] = (ELEM_TYPE)dt.rem;
-
-		bool found = false;
-		for (size_t i = digit < rhs.val.size() ? 0 : digit - rhs.val.size() + 1;
-			 i < val.size() && i <= digit;
-			 ++i) {
-			PRODUCT_TYPE pval = result.val[digit] + val[i] * (PRODUCT_TYPE)rhs.val[digit - i];
-			if (pval >= BASE || pval <= -BASE) {
-				lldiv_t dt = my_lldiv(pval, BASE);
-				carry += dt.quot;
-				pval = dt.rem;
-			}
-			result.val[digit] = (ELEM_TYPE)pval;
-			found = true;
-		}
-		if (!found) {
-			break;
-		}
-	}
-	for (; carry > 0; ++digit) {
-		lldiv_t dt = my_lldiv(carry, BASE);
-		result.val[digit] = (ELEM_TYPE)dt.rem;
-		carry = dt.quot;
-	}
-	result.correct();
-	result.pos = (result.val.size() == 1 && result.val[0] == 0) ? true : (pos == rhs.pos);
+	if (val.empty() || rhs.val.empty())
+		return result;
+	result.val.resize(val.size() + rhs.val.size());
+	infint_detail::multiply(
+		val.data(), val.size(), rhs.val.data(), rhs.val.size(), result.val.data());
+	infint_detail::trim(result.val);
+	result.pos = pos == rhs.pos;
 	return result;
 }
 
 inline InfInt InfInt::operator/(const InfInt& rhs) const {
-	// PROFINY_SCOPE
-	if (rhs == 0) {
-#ifdef INFINT_USE_EXCEPTIONS
-		throw InfIntException("division by zero");
-#else
-		std::cerr << "Division by zero!" << endl;
-		return 0;
-#endif
-	}
-	InfInt Q, R, D = (rhs.pos ? rhs : -rhs), N = (pos ? *this : -*this);
-	Q.val.resize(N.val.size(), 0);
-	for (int i = (int)N.val.size() - 1; i >= 0; --i) {
-		R.val.insert(R.val.begin(), N.val[i]);
-		R.correct(true);
-		ELEM_TYPE cnt = dInR(R, D);
-		R -= D * cnt;
-		Q.val[i] += cnt;
-	}
-	Q.correct();
-	Q.pos = (Q.val.size() == 1 && Q.val[0] == 0) ? true : (pos == rhs.pos);
-	return Q;
+	InfInt result;
+	if (divisionByZero(rhs))
+		return result;
+	divide(*this, rhs, &result, nullptr);
+	return result;
 }
 
 inline InfInt InfInt::operator%(const InfInt& rhs) const {
-	// PROFINY_SCOPE
-	if (rhs == 0) {
-#ifdef INFINT_USE_EXCEPTIONS
-		throw InfIntException("division by zero");
-#else
-		std::cerr << "Division by zero!" << endl;
-		return 0;
-#endif
-	}
-	InfInt R, D = (rhs.pos ? rhs : -rhs), N = (pos ? *this : -*this);
-	for (int i = (int)N.val.size() - 1; i >= 0; --i) {
-		R.val.insert(R.val.begin(), N.val[i]);
-		R.correct(true);
-		R -= D * dInR(R, D);
-	}
-	R.correct();
-	R.pos = (R.val.size() == 1 && R.val[0] == 0) ? true : pos;
-	return R;
+	InfInt result;
+	if (divisionByZero(rhs))
+		return result;
+	divide(*this, rhs, nullptr, &result);
+	return result;
 }
 
-inline InfInt InfInt::operator*(ELEM_TYPE rhs) const {
-	// PROFINY_SCOPE
+inline InfInt InfInt::operator*(int rhs) const {
 	InfInt result = *this;
-	ELEM_TYPE factor = rhs < 0 ? -rhs : rhs;
-	multiplyByDigit(factor, result.val);
-	result.correct();
-	result.pos = (result.val.size() == 1 && result.val[0] == 0) ? true : (pos == (rhs >= 0));
+	result *= rhs;
 	return result;
 }
 
 inline bool InfInt::operator==(const InfInt& rhs) const {
-	// PROFINY_SCOPE
-	if (pos != rhs.pos || val.size() != rhs.val.size()) {
-		return false;
-	}
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		if (val[i] != rhs.val[i]) {
-			return false;
-		}
-	}
-	return true;
+	return pos == rhs.pos && val == rhs.val;
 }
 
 inline bool InfInt::operator!=(const InfInt& rhs) const {
-	// PROFINY_SCOPE
-	if (pos != rhs.pos || val.size() != rhs.val.size()) {
-		return true;
-	}
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		if (val[i] != rhs.val[i]) {
-			return true;
-		}
-	}
-	return false;
+	return !(*this == rhs);
 }
 
 inline bool InfInt::operator<(const InfInt& rhs) const {
-	// PROFINY_SCOPE
-	if (pos && !rhs.pos) {
-		return false;
-	}
-	if (!pos && rhs.pos) {
-		return true;
-	}
-	if (val.size() > rhs.val.size()) {
-		return pos ? false : true;
-	}
-	if (val.size() < rhs.val.size()) {
-		return pos ? true : false;
-	}
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		if (val[i] < rhs.val[i]) {
-			return pos ? true : false;
-		}
-		if (val[i] > rhs.val[i]) {
-			return pos ? false : true;
-		}
-	}
-	return false;
+	if (pos != rhs.pos)
+		return !pos;
+	int c = infint_detail::compare(val, rhs.val);
+	return pos ? c < 0 : c > 0;
 }
 
 inline bool InfInt::operator<=(const InfInt& rhs) const {
-	// PROFINY_SCOPE
-	if (pos && !rhs.pos) {
-		return false;
-	}
-	if (!pos && rhs.pos) {
-		return true;
-	}
-	if (val.size() > rhs.val.size()) {
-		return pos ? false : true;
-	}
-	if (val.size() < rhs.val.size()) {
-		return pos ? true : false;
-	}
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		if (val[i] < rhs.val[i]) {
-			return pos ? true : false;
-		}
-		if (val[i] > rhs.val[i]) {
-			return pos ? false : true;
-		}
-	}
-	return true;
+	return !(rhs < *this);
 }
 
 inline bool InfInt::operator>(const InfInt& rhs) const {
-	// PROFINY_SCOPE
-	if (pos && !rhs.pos) {
-		return true;
-	}
-	if (!pos && rhs.pos) {
-		return false;
-	}
-	if (val.size() > rhs.val.size()) {
-		return pos ? true : false;
-	}
-	if (val.size() < rhs.val.size()) {
-		return pos ? false : true;
-	}
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		if (val[i] < rhs.val[i]) {
-			return pos ? false : true;
-		}
-		if (val[i] > rhs.val[i]) {
-			return pos ? true : false;
-		}
-	}
-	return false;
+	return rhs < *this;
 }
 
 inline bool InfInt::operator>=(const InfInt& rhs) const {
-	// PROFINY_SCOPE
-	if (pos && !rhs.pos) {
-		return true;
-	}
-	if (!pos && rhs.pos) {
-		return false;
-	}
-	if (val.size() > rhs.val.size()) {
-		return pos ? true : false;
-	}
-	if (val.size() < rhs.val.size()) {
-		return pos ? false : true;
-	}
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		if (val[i] < rhs.val[i]) {
-			return pos ? false : true;
-		}
-		if (val[i] > rhs.val[i]) {
-			return pos ? true : false;
-		}
-	}
-	return true;
-}
-
-inline void InfInt::optimizeSqrtSearchBounds(InfInt& lo, InfInt& hi) const {
-	// PROFINY_SCOPE
-	InfInt hdn = 1;
-	for (int i = (int)this->numberOfDigits() / 2; i >= 2; --i) {
-		hdn *= 10;
-	}
-	if (lo < hdn) {
-		lo = hdn;
-	}
-	hdn *= 100;
-	if (hi > hdn) {
-		hi = hdn;
-	}
+	return !(*this < rhs);
 }
 
 inline InfInt InfInt::intSqrt() const {
-	// PROFINY_SCOPE
 	if (*this <= 0) {
 #ifdef INFINT_USE_EXCEPTIONS
 		throw InfIntException("intSqrt called for non-positive integer");
@@ -833,25 +822,27 @@ inline InfInt InfInt::intSqrt() const {
 		return 0;
 #endif
 	}
-	InfInt hi = *this / 2 + 1, lo = 0, mid, mid2;
-	optimizeSqrtSearchBounds(lo, hi);
-	do {
-		mid = (hi + lo) / 2; // 8 factor
-		mid2 = mid * mid;	 // 1 factor
-		if (mid2 == *this) {
-			lo = mid;
-			break;
-		} else if (mid2 < *this) {
-			lo = mid;
-		} else {
-			hi = mid;
-		}
-	} while (lo < hi - 1 && mid2 != *this);
-	return lo;
+	/* Newton's iterations descending from a power of two above the root */
+	size_t bits = val.size() * 64 - infint_detail::countLeadingZeros(val.back());
+	size_t half = (bits + 1) / 2;
+	InfInt x;
+	x.val.assign(half / 64 + 1, 0);
+	x.val.back() = limb(1) << (half % 64);
+	while (true) {
+		InfInt y = (x + *this / x) / 2;
+		if (y >= x)
+			return x;
+		x = std::move(y);
+	}
+}
+
+inline InfInt InfInt::gcd(const InfInt& a, const InfInt& b) {
+	InfInt result;
+	result.val = infint_detail::gcd(a.val, b.val);
+	return result;
 }
 
 inline char InfInt::digitAt(size_t i) const {
-	// PROFINY_SCOPE
 	if (numberOfDigits() <= i) {
 #ifdef INFINT_USE_EXCEPTIONS
 		throw InfIntException("invalid digit index");
@@ -860,43 +851,31 @@ inline char InfInt::digitAt(size_t i) const {
 		return -1;
 #endif
 	}
-	return (val[i / DIGIT_COUNT] / powersOfTen[i % DIGIT_COUNT]) % 10;
+	limb chunk = toDecimal()[i / infint_detail::DECIMAL_DIGITS];
+	for (size_t j = i % infint_detail::DECIMAL_DIGITS; j > 0; j--)
+		chunk /= 10;
+	return chunk % 10;
 }
 
 inline size_t InfInt::numberOfDigits() const {
-	// PROFINY_SCOPE
-	return (val.size() - 1) * DIGIT_COUNT +
-		   (val.back() > 99999999
-				? 9
-				: (val.back() > 9999999
-					   ? 8
-					   : (val.back() > 999999
-							  ? 7
-							  : (val.back() > 99999
-									 ? 6
-									 : (val.back() > 9999
-											? 5
-											: (val.back() > 999
-												   ? 4
-												   : (val.back() > 99
-														  ? 3
-														  : (val.back() > 9 ? 2 : 1))))))));
+	vector<limb> chunks = toDecimal();
+	size_t digits = (chunks.size() - 1) * infint_detail::DECIMAL_DIGITS + 1;
+	for (limb top = chunks.back(); top > 9; top /= 10)
+		digits++;
+	return digits;
 }
 
 inline string InfInt::toString() const {
-	// PROFINY_SCOPE
 	std::stringstream oss;
 	oss << *this;
 	return oss.str();
 }
 
 inline size_t InfInt::size() const {
-	// PROFINY_SCOPE
-	return val.size() * sizeof(ELEM_TYPE) + sizeof(bool);
+	return val.size() * sizeof(limb) + sizeof(bool);
 }
 
 inline int InfInt::toInt() const {
-	// PROFINY_SCOPE
 	if (*this > INT_MAX || *this < INT_MIN) {
 #ifdef INFINT_USE_EXCEPTIONS
 		throw InfIntException("out of bounds");
@@ -904,15 +883,10 @@ inline int InfInt::toInt() const {
 		std::cerr << "Out of INT bounds: " << *this << endl;
 #endif
 	}
-	int result = 0;
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		result = result * BASE + val[i];
-	}
-	return pos ? result : -result;
+	return static_cast<int>(lowBits());
 }
 
 inline long InfInt::toLong() const {
-	// PROFINY_SCOPE
 	if (*this > LONG_MAX || *this < LONG_MIN) {
 #ifdef INFINT_USE_EXCEPTIONS
 		throw InfIntException("out of bounds");
@@ -920,15 +894,10 @@ inline long InfInt::toLong() const {
 		std::cerr << "Out of LONG bounds: " << *this << endl;
 #endif
 	}
-	long result = 0;
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		result = result * BASE + val[i];
-	}
-	return pos ? result : -result;
+	return static_cast<long>(lowBits());
 }
 
 inline long long InfInt::toLongLong() const {
-	// PROFINY_SCOPE
 	if (*this > LONG_LONG_MAX || *this < LONG_LONG_MIN) {
 #ifdef INFINT_USE_EXCEPTIONS
 		throw InfIntException("out of bounds");
@@ -936,15 +905,10 @@ inline long long InfInt::toLongLong() const {
 		std::cerr << "Out of LLONG bounds: " << *this << endl;
 #endif
 	}
-	long long result = 0;
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		result = result * BASE + val[i];
-	}
-	return pos ? result : -result;
+	return static_cast<long long>(lowBits());
 }
 
 inline unsigned int InfInt::toUnsignedInt() const {
-	// PROFINY_SCOPE
 	if (!pos || *this > UINT_MAX) {
 #ifdef INFINT_USE_EXCEPTIONS
 		throw InfIntException("out of bounds");
@@ -952,15 +916,10 @@ inline unsigned int InfInt::toUnsignedInt() const {
 		std::cerr << "Out of UINT bounds: " << *this << endl;
 #endif
 	}
-	unsigned int result = 0;
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		result = result * BASE + val[i];
-	}
-	return result;
+	return static_cast<unsigned int>(lowBits());
 }
 
 inline unsigned long InfInt::toUnsignedLong() const {
-	// PROFINY_SCOPE
 	if (!pos || *this > ULONG_MAX) {
 #ifdef INFINT_USE_EXCEPTIONS
 		throw InfIntException("out of bounds");
@@ -968,15 +927,10 @@ inline unsigned long InfInt::toUnsignedLong() const {
 		std::cerr << "Out of ULONG bounds: " << *this << endl;
 #endif
 	}
-	unsigned long result = 0;
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		result = result * BASE + val[i];
-	}
-	return result;
+	return static_cast<unsigned long>(lowBits());
 }
 
 inline unsigned long long InfInt::toUnsignedLongLong() const {
-	// PROFINY_SCOPE
 	if (!pos || *this > ULONG_LONG_MAX) {
 #ifdef INFINT_USE_EXCEPTIONS
 		throw InfIntException("out of bounds");
@@ -984,167 +938,81 @@ inline unsigned long long InfInt::toUnsignedLongLong() const {
 		std::cerr << "Out of ULLONG bounds: " << *this << endl;
 #endif
 	}
-	unsigned long long result = 0;
-	for (int i = (int)val.size() - 1; i >= 0; --i) {
-		result = result * BASE + val[i];
-	}
-	return result;
+	return lowBits();
 }
 
-inline void InfInt::truncateToBase() {
-	// PROFINY_SCOPE
-	for (size_t i = 0; i < val.size(); ++i) // truncate each
-	{
-		if (val[i] >= BASE || val[i] <= -BASE) {
-			div_t dt = my_div(val[i], BASE);
-			val[i] = dt.rem;
-			if (i + 1 >= val.size()) {
-				val.push_back(dt.quot);
-			} else {
-				val[i + 1] += dt.quot;
-			}
-		}
-	}
+inline void InfInt::assign(unsigned long long magnitude, bool positive) {
+	val.clear();
+	if (magnitude)
+		val.push_back(magnitude);
+	pos = positive || !magnitude;
 }
 
-inline bool InfInt::equalizeSigns() {
-	// PROFINY_SCOPE
-	bool isPositive = true;
-	int i = (int)((val.size())) - 1;
-	for (; i >= 0; --i) {
-		if (val[i] != 0) {
-			isPositive = val[i--] > 0;
-			break;
-		}
-	}
-
-	if (isPositive) {
-		for (; i >= 0; --i) {
-			if (val[i] < 0) {
-				int k = 0, index = i + 1;
-				for (; (size_t)(index) < val.size() && val[index] == 0; ++k, ++index)
-					; // count adjacent zeros on left
-				// if ((size_t)(index) < val.size() && val[index] > 0)
-				{ // number on the left is positive
-					val[index] -= 1;
-					val[i] += BASE;
-					for (; k > 0; --k) {
-						val[i + k] = UPPER_BOUND;
-					}
-				}
-			}
-		}
+inline void InfInt::add(const InfInt& rhs, bool rhsPos) {
+	if (pos == rhsPos) {
+		infint_detail::addAbs(val, rhs.val);
+	} else if (infint_detail::compare(val, rhs.val) >= 0) {
+		infint_detail::subtractAbs(val, rhs.val);
 	} else {
-		for (; i >= 0; --i) {
-			if (val[i] > 0) {
-				int k = 0, index = i + 1;
-				for (; (size_t)(index) < val.size() && val[index] == 0; ++k, ++index)
-					; // count adjacent zeros on right
-				// if ((size_t)(index) < val.size() && val[index] < 0)
-				{ // number on the left is negative
-					val[index] += 1;
-					val[i] -= BASE;
-					for (; k > 0; --k) {
-						val[i + k] = -UPPER_BOUND;
-					}
-				}
-			}
-		}
+		vector<limb> difference = rhs.val;
+		infint_detail::subtractAbs(difference, val);
+		val.swap(difference);
+		pos = rhsPos;
 	}
-
-	return isPositive;
+	if (val.empty())
+		pos = true;
 }
 
-inline void InfInt::removeLeadingZeros() {
-	// PROFINY_SCOPE
-	for (int i = (int)(val.size()) - 1; i > 0; --i) // remove leading 0's
-	{
-		if (val[i] != 0) {
-			return;
-		} else {
-			val.erase(val.begin() + i);
+inline void InfInt::fromString(const string& s) {
+	val.clear();
+	size_t i = 0;
+	bool negative = false;
+	if (i < s.size() && (s[i] == '-' || s[i] == '+'))
+		negative = s[i++] == '-';
+	while (i < s.size()) {
+		limb chunk = 0, factor = 1;
+		for (int j = 0; j < infint_detail::DECIMAL_DIGITS && i < s.size(); j++, i++) {
+			chunk = chunk * 10 + (s[i] - '0');
+			factor *= 10;
 		}
+		infint_detail::multiplyAddSmall(val, factor, chunk);
 	}
+	pos = !negative || val.empty();
 }
 
-inline void InfInt::correct(bool justCheckLeadingZeros, bool hasValidSign) {
-	// PROFINY_SCOPE
-	if (!justCheckLeadingZeros) {
-		truncateToBase();
+inline bool InfInt::divisionByZero(const InfInt& rhs) const {
+	if (!rhs.val.empty())
+		return false;
+#ifdef INFINT_USE_EXCEPTIONS
+	throw InfIntException("division by zero");
+#else
+	std::cerr << "Division by zero!" << endl;
+	return true;
+#endif
+}
 
-		if (equalizeSigns()) {
-			pos = ((val.size() == 1 && val[0] == 0) || !hasValidSign) ? true : pos;
-		} else {
-			pos = hasValidSign ? !pos : false;
-			for (size_t i = 0; i < val.size(); ++i) {
-				val[i] = abs(val[i]);
-			}
-		}
-	}
+inline void InfInt::divide(const InfInt& n, const InfInt& d, InfInt* q, InfInt* r) {
+	/* truncating division: the quotient is rounded towards zero,
+	 * the remainder takes the sign of the dividend */
+	bool qPos = n.pos == d.pos, rPos = n.pos;
+	infint_detail::divide(n.val, d.val, q ? &q->val : nullptr, r ? &r->val : nullptr);
+	if (q)
+		q->pos = qPos || q->val.empty();
+	if (r)
+		r->pos = rPos || r->val.empty();
+}
 
-	removeLeadingZeros();
+inline vector<infint_detail::limb> InfInt::toDecimal() const {
+	vector<limb> magnitude = val, chunks;
+	do {
+		chunks.push_back(infint_detail::divideSmall(magnitude, infint_detail::DECIMAL_BASE));
+	} while (!magnitude.empty());
+	return chunks;
 }
 
-inline void InfInt::fromString(const string& s) {
-	// PROFINY_SCOPE
-	pos = true;
-	val.clear();
-	val.reserve(s.size() / DIGIT_COUNT + 1);
-	int i = (int)s.size() - DIGIT_COUNT;
-	for (; i >= 0; i -= DIGIT_COUNT) {
-		val.push_back(atoi(s.substr(i, DIGIT_COUNT).c_str()));
-	}
-	if (i > -DIGIT_COUNT) {
-		string ss = s.substr(0, i + DIGIT_COUNT);
-		if (ss.size() == 1 && ss[0] == '-') {
-			pos = false;
-		} else {
-			val.push_back(atoi(ss.c_str()));
-		}
-	}
-	if (val.back() < 0) {
-		val.back() = -val.back();
-		pos = false;
-	}
-	correct(true);
-}
-
-inline ELEM_TYPE InfInt::dInR(const InfInt& R, const InfInt& D) {
-	// PROFINY_SCOPE
-	ELEM_TYPE min = 0, max = UPPER_BOUND;
-	while (max > min) {
-		ELEM_TYPE avg = max + min;
-		div_t dt = my_div(avg, 2);
-		avg = dt.rem ? (dt.quot + 1) : dt.quot;
-		InfInt prod = D * avg;
-		if (R == prod) {
-			return avg;
-		} else if (R > prod) {
-			min = avg;
-		} else {
-			max = avg - 1;
-		}
-	}
-	return min;
-}
-
-inline void InfInt::multiplyByDigit(ELEM_TYPE factor, vector<ELEM_TYPE>& val) {
-	// PROFINY_SCOPE
-	ELEM_TYPE carry = 0;
-	for (size_t i = 0; i < val.size(); ++i) {
-		PRODUCT_TYPE pval = val[i] * (PRODUCT_TYPE)factor + carry;
-		if (pval >= BASE || pval <= -BASE) {
-			lldiv_t dt = my_lldiv(pval, BASE);
-			carry = (ELEM_TYPE)dt.quot;
-			pval = dt.rem;
-		} else {
-			carry = 0;
-		}
-		val[i] = (ELEM_TYPE)pval;
-	}
-	if (carry > 0) {
-		val.push_back(carry);
-	}
+inline unsigned long long InfInt::lowBits() const {
+	unsigned long long low = val.empty() ? 0 : val[0];
+	return pos ? low : 0ULL - low;
 }
 
 /**************************************************************/
@@ -1152,7 +1020,6 @@ inline void InfInt::multiplyByDigit(ELEM_TYPE factor, vector<ELEM_TYPE>& val) {
 /**************************************************************/
 
 inline std::istream& operator>>(std::istream& s, InfInt& n) {
-	// PROFINY_SCOPE
 	string str;
 	s >> str;
 	n.fromString(str);
@@ -1160,19 +1027,12 @@ inline std::istream& operator>>(std::istream& s, InfInt& n) {
 }
 
 inline std::ostream& operator<<(std::ostream& s, const InfInt& n) {
-	// PROFINY_SCOPE
-	if (!n.pos) {
+	if (!n.pos)
 		s << '-';
-	}
-	bool first = true;
-	for (int i = (int)n.val.size() - 1; i >= 0; --i) {
-		if (first) {
-			s << n.val[i];
-			first = false;
-		} else {
-			s << std::setfill('0') << std::setw(DIGIT_COUNT) << n.val[i];
-		}
-	}
+	vector<infint_detail::limb> chunks = n.toDecimal();
+	s << chunks.back();
+	for (size_t i = chunks.size() - 1; i-- > 0;)
+		s << std::setfill('0') << std::setw(infint_detail::DECIMAL_DIGITS) << chunks[i];
 	return s;
 }
 
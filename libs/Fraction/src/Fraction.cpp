@@ -1,96 +1,101 @@
+#include <stdexcept>
+#include <utility>
+
 #include "Fraction/Fraction.h"
 
-Fraction::Fraction() {
-	numerator = 0;
-	denominator = 1;
-}
+Fraction::Fraction() : numerator(0), denominator(1), is_reduced(true) {}
 
-Fraction::Fraction(InfInt n, InfInt d) {
-	if (d == 0)
+Fraction::Fraction(InfInt n, InfInt d)
+	: numerator(std::move(n)), denominator(std::move(d)), is_reduced(false) {
+	if (denominator == 0)
 		throw std::invalid_argument("d");
-	numerator = n;
-	denominator = d;
-	simplify();
+	fix_sign();
 }
 
 Fraction::~Fraction() {}
 
-Fraction Fraction::operator+(const Fraction& f) {
-	InfInt n = numerator * f.denominator + f.numerator * denominator;
-	InfInt d = denominator * f.denominator;
-
-	Fraction ff(n, d);
-	return ff;
+Fraction Fraction::operator+(const Fraction& f) const {
+	if (denominator == f.denominator)
+		return Fraction(numerator + f.numerator, denominator);
+	return Fraction(numerator * f.denominator + f.numerator * denominator,
+					denominator * f.denominator);
 }
 
-Fraction Fraction::operator-(const Fraction& f) {
-	InfInt n = numerator * f.denominator - f.numerator * denominator;
-	InfInt d = denominator * f.denominator;
-	last_number_of_digits = n.numberOfDigits() + d.numberOfDigits();
-
-	Fraction ff(n, d);
-	return ff;
+Fraction Fraction::operator-(const Fraction& f) const {
+	if (denominator == f.denominator)
+		return Fraction(numerator - f.numerator, denominator);
+	return Fraction(numerator * f.denominator - f.numerator * denominator,
+					denominator * f.denominator);
 }
 
-Fraction Fraction::operator*(const Fraction& f) {
-	InfInt n = numerator * f.numerator;
-	InfInt d = denominator * f.denominator;
-
-	Fraction ff(n, d);
-	return ff;
+Fraction Fraction::operator*(const Fraction& f) const {
+	return Fraction(numerator * f.numerator, denominator * f.denominator);
 }
 
-Fraction Fraction::operator/(const Fraction& f) {
-	InfInt n = numerator * f.denominator;
-	InfInt d = denominator * f.numerator;
-
-	Fraction ff(n, d);
-	return ff;
+Fraction Fraction::operator/(const Fraction& f) const {
+	return Fraction(numerator * f.denominator, denominator * f.numerator);
 }
 
 Fraction Fraction::operator+=(const Fraction& f) {
-	numerator = numerator * f.denominator + f.numerator * denominator;
-	denominator = denominator * f.denominator;
-	simplify();
-
+	if (denominator == f.denominator) {
+		numerator += f.numerator;
+	} else {
+		numerator *= f.denominator;
+		numerator += f.numerator * denominator;
+		denominator *= f.denominator;
+	}
+	is_reduced = false;
 	return *this;
 }
 
 Fraction Fraction::operator++() {
-	Fraction f(1, 1);
-	numerator = numerator * f.denominator + f.numerator * denominator;
-	denominator = denominator * f.denominator;
-	simplify();
-
+	numerator += denominator;
 	return *this;
 }
 
 Fraction Fraction::operator++(int) {
-	Fraction ff(numerator, denominator);
-	Fraction f(1, 1);
-	numerator = numerator * f.denominator + f.numerator * denominator;
-	denominator = denominator * f.denominator;
-	simplify();
-
+	Fraction ff = *this;
+	numerator += denominator;
 	return ff;
 }
 
-bool Fraction::operator>(const Fraction& f) {
-	InfInt n = numerator * f.denominator - f.numerator * denominator;
-	return n > 0;
+int Fraction::compare(const Fraction& f) const {
+	reduction();
+	f.reduction();
+	if (denominator == f.denominator)
+		return numerator < f.numerator ? -1 : (f.numerator < numerator ? 1 : 0);
+	InfInt left = numerator * f.denominator, right = f.numerator * denominator;
+	return left < right ? -1 : (right < left ? 1 : 0);
 }
 
-bool Fraction::operator==(const Fraction& f) {
-	InfInt n = numerator * f.denominator - f.numerator * denominator;
-	return n == 0;
+bool Fraction::operator>(const Fraction& f) const {
+	return compare(f) > 0;
 }
 
-bool Fraction::operator>=(const Fraction& f) {
+bool Fraction::operator==(const Fraction& f) const {
+	// у сокращённых дробей с положительными знаменателями запись единственна
+	reduction();
+	f.reduction();
+	return numerator == f.numerator && denominator == f.denominator;
+}
+
+bool Fraction::operator>=(const Fraction& f) const {
+	return compare(f) >= 0;
+}
+
+Fraction Fraction::subtract(const Fraction& f, Context& context) const {
+	// размер считается по сокращённым операндам, чтобы не зависеть от того, когда
+	// они были сокращены
+	reduction();
+	f.reduction();
 	InfInt n = numerator * f.denominator - f.numerator * denominator;
-	return n >= 0;
+	InfInt d = denominator * f.denominator;
+	context.last_number_of_digits = n.numberOfDigits() + d.numberOfDigits();
+	return Fraction(std::move(n), std::move(d));
 }
 
 std::ostream& operator<<(std::ostream& output, const Fraction& f) {
+	f.reduction();
 	output << "(" << f.numerator << "/" << f.denominator << ")";
 	return output;
-}
\ No newline at end of file
+}
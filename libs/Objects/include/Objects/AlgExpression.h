@@ -31,7 +31,8 @@ class AlgExpression : public BaseObject {
 		Symbol symbol; // символ алфавита регулярки или ссылка(&i)
 		int number = 0; // Для указания номера (при линеаризации) в to_glushkov и to_mfa
 						// либо для указания номера ячейки памяти (Type: squareBrL, squareBrL, ref),
-						// чтобы использовать в scan_ref и scan_square_br
+						// чтобы использовать при построении ref и memoryWriter
+		size_t position = 0; // позиция лексемы во входной строке (для сообщений об ошибках)
 		Lexeme(Type type = error, const Symbol& symbol = Symbol(),
 			   int number = 0); // NOLINT(runtime/explicit)
 	};
@@ -51,8 +52,6 @@ class AlgExpression : public BaseObject {
 		ref,
 	};
 
-	// множество уникальных символов алфавита в дереве
-	Alphabet alphabet;
 	Type type;
 	// символ алфавита регулярки или ссылка(&i)
 	Symbol symbol;
@@ -66,11 +65,17 @@ class AlgExpression : public BaseObject {
 	virtual AlgExpression* make() const = 0;
 
 	void clear();
+	// забирает дерево и язык other своего типа, оставляя в нём eps без языка
+	// (память this должна быть очищена)
+	virtual void move_from(AlgExpression& other) noexcept; // NOLINT(runtime/references)
 
-	// Рекурсивная генерация алфавита во всех нодах
-	void generate_alphabet();
+	// собирает символы листьев дерева (сами узлы алфавит не хранят, он есть только в языке)
+	Alphabet generate_alphabet() const;
 	// Генерация алфавита и создание нового языка
 	void make_language();
+	// язык выражения, а если его нет (выражение перемещено или создано по умолчанию) -
+	// новый язык из символов дерева, который получает только результат преобразования
+	std::shared_ptr<Language> get_or_make_language() const;
 	// для print_tree
 	void print_subtree(AlgExpression* expr, int level) const;
 	// для print_dot
@@ -82,20 +87,18 @@ class AlgExpression : public BaseObject {
 	// Turns string into lexeme vector
 	static std::vector<Lexeme> parse_string(std::string, bool allow_ref = false,
 											bool allow_negation = true);
-	bool from_string(const std::string&, bool allow_ref = false, bool allow_negation = true);
+	// при ошибке возвращает false, а в error_position - позицию ошибки во входной строке
+	bool from_string(const std::string&, size_t& error_position, // NOLINT(runtime/references)
+					 bool allow_ref = false, bool allow_negation = true);
 
-	// возвращаемый тип нижеперечисленных методов зависит от типа объекта (Regex/BackRefRegex)
+	// тип создаваемых узлов зависит от типа объекта (Regex/BackRefRegex),
 	// внутреннее состояние не имеет значения
-	// Построение из вектора лексем дерева регулярного выражения
-	// 2 и 3 аргумент - это начальный и конечный индекс рассматриваемых лексем в векторе
-	virtual AlgExpression* expr(const std::vector<Lexeme>&, int, int) = 0;
-	AlgExpression* scan_conc(const std::vector<Lexeme>&, int, int);
-	AlgExpression* scan_star(const std::vector<Lexeme>&, int, int);
-	AlgExpression* scan_alt(const std::vector<Lexeme>&, int, int);
-	AlgExpression* scan_symb(const std::vector<Lexeme>&, int, int);
-	AlgExpression* scan_eps(const std::vector<Lexeme>&, int, int);
-	AlgExpression* scan_par(const std::vector<Lexeme>&, int, int);
-	static void update_balance(const AlgExpression::Lexeme&, int&);
+	// Построение дерева регулярного выражения из вектора лексем за один проход
+	// (сортировочная станция с явными стеками операндов и операторов, без рекурсии)
+	AlgExpression* expr(const std::vector<Lexeme>&,
+						size_t& error_position) const; // NOLINT(runtime/references)
+	// создаёт узел типа Type по лексеме, из которой он получен
+	virtual AlgExpression* make_node(Type, const Lexeme&) const;
 
 	virtual bool equals(const AlgExpression* other) const = 0;
 
@@ -114,7 +117,7 @@ class AlgExpression : public BaseObject {
 
   public:
 	AlgExpression();
-	AlgExpression(std::shared_ptr<Language>, Type, const Symbol&, Alphabet);
+	AlgExpression(std::shared_ptr<Language>, Type, const Symbol&);
 	AlgExpression(Type, const Symbol&);
 	explicit AlgExpression(Alphabet);
 	// переданные term_l и term_l копируются с помощью make_copy
@@ -126,6 +129,15 @@ class AlgExpression : public BaseObject {
 	// возвращает указатель на копию себя
 	virtual AlgExpression* make_copy() const = 0;
 	AlgExpression(const AlgExpression&);
+	AlgExpression(AlgExpression&&) noexcept;
+
+	// узлы выделяются из пула потока: страницы по 64 КБ нарезаются на блоки размера узла,
+	// освобождённые блоки переиспользуются, поэтому разбор, копирование и удаление
+	// дерева не обращаются к системному аллокатору на каждый узел. Узел, освобождённый в
+	// другом потоке, возвращается в пул создавшего его потока. Страницы возвращаются системе,
+	// когда этот поток завершился и все их узлы освобождены
+	static void* operator new(std::size_t size);
+	static void operator delete(void* ptr, std::size_t size);
 
 	Symbol get_symbol() const;
 	Type get_type() const;
@@ -142,6 +154,7 @@ class AlgExpression : public BaseObject {
 	void print_dot() const;
 
 	friend class FiniteAutomaton;
+	friend class RegexDAG;
 	friend class Tester;
 	friend class UnitTests;
 };
\ No newline at end of file
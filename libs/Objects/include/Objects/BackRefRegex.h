@@ -29,14 +29,14 @@ class BackRefRegex : public AlgExpression {
 	bool may_be_eps = false;
 
 	void copy(const AlgExpression*) override; // NOLINT(build/include_what_you_use)
+	void move_from(AlgExpression& other) noexcept override; // NOLINT(runtime/references)
 	// возвращает указатель на new BackRefRegex
 	BackRefRegex* make() const override;
 
 	std::string type_to_str() const override;
 
-	BackRefRegex* expr(const std::vector<Lexeme>&, int, int) override;
-	BackRefRegex* scan_ref(const std::vector<Lexeme>&, int, int);
-	BackRefRegex* scan_square_br(const std::vector<Lexeme>&, int, int);
+	// для ref и memoryWriter переносит номер ячейки памяти из лексемы
+	BackRefRegex* make_node(Type, const Lexeme&) const override;
 
 	bool equals(const AlgExpression* other) const override;
 
@@ -98,7 +98,9 @@ class BackRefRegex : public AlgExpression {
 
 	BackRefRegex* make_copy() const override;
 	BackRefRegex(const BackRefRegex&);
+	BackRefRegex(BackRefRegex&&) noexcept;
 	BackRefRegex& operator=(const BackRefRegex& other);
+	BackRefRegex& operator=(BackRefRegex&& other) noexcept;
 
 	// dynamic_cast к типу BackRefRegex*
 	template <typename T> static BackRefRegex* cast(T* ptr, bool not_null_ptr = true);
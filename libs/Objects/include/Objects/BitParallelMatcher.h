@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class Regex;
+
+// Битово-параллельное моделирование автомата Глушкова (Shift-And для позиционного автомата).
+// Бит 0 соответствует начальному состоянию, бит i - i-й позиции регулярки; множество активных
+// позиций хранится в words_count() 64-битных словах. На очередном байте c
+//	D' = Follow(D) & B[c],
+// где B[c] - позиции, помеченные c, а Follow(D) собирается по байтам D из заранее
+// вычисленных таблиц: для каждого байта маски и каждого из 256 его значений хранится
+// объединение follow-множеств его позиций.
+// Символы регулярки, не записываемые одним байтом без разметки, при разборе не используются.
+class BitParallelMatcher {
+  private:
+	// до стольких слов маски разбор идёт без выделения памяти
+	static constexpr size_t max_stack_words = 64;
+
+	size_t positions_number;
+	size_t words_number;
+	size_t chunks_number;
+	// symbol_masks[c * words_number + w] - w-е слово маски B[c]
+	std::vector<uint64_t> symbol_masks;
+	// follow_table[(chunk * 256 + value) * words_number + w]
+	std::vector<uint64_t> follow_table;
+	std::vector<uint64_t> final_mask;
+
+	bool match_single_word(std::string_view) const;
+	bool match_multi_word(std::string_view, uint64_t* buffer) const;
+
+  public:
+	explicit BitParallelMatcher(const Regex&);
+
+	// число позиций автомата Глушкова вместе с начальным состоянием
+	size_t positions_count() const;
+	size_t words_count() const;
+
+	bool match(std::string_view) const;
+	// i-й элемент результата - принадлежность языку i-го слова
+	std::vector<bool> match(const std::vector<std::string_view>&) const;
+	// разбор с подсчётом шагов для Tester: шаг - обработка одного слова маски на одном байте
+	std::pair<int, bool> parse(const std::string&) const;
+};
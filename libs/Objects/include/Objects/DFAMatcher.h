@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "StreamMatcher.h"
+
+class FiniteAutomaton;
+
+// Скомпилированный ДКА для быстрой проверки принадлежности слов языку.
+// Байты входа разбиваются на классы эквивалентности (байты одного класса ведут из каждого
+// состояния в одно и то же состояние), переходы хранятся плотной таблицей uint32_t,
+// строки которой индексируются классами байтов. Состояния хранятся сразу как смещения
+// строк таблицы, поэтому на каждый байт входа приходится одно чтение из таблицы
+// (плюс чтение класса байта).
+// Символы автомата, не записываемые одним байтом без разметки, в таблицу не попадают.
+class DFAMatcher {
+  private:
+	std::array<uint32_t, 256> byte_class;
+	size_t classes_number = 0;
+	size_t states_number = 0;
+	// смещение строки таблицы для начального состояния и для ловушки
+	uint32_t initial_offset = 0;
+	uint32_t trap_offset = 0;
+	std::vector<uint32_t> table;
+	// битовая маска финальных состояний по номерам строк таблицы
+	std::vector<uint64_t> accepting;
+
+	bool is_accepting(uint32_t offset) const;
+
+  public:
+	// потоковый разбор по таблице matcher, который должен жить дольше потока
+	class Stream : public StreamMatcher {
+	  private:
+		const DFAMatcher& matcher;
+		uint32_t offset;
+
+	  public:
+		explicit Stream(const DFAMatcher& matcher);
+
+		void reset() override;
+		bool feed(std::string_view chunk) override;
+		bool finish() const override;
+	};
+
+	// недетерминированный автомат предварительно детерминизируется
+	explicit DFAMatcher(const FiniteAutomaton&);
+
+	// число состояний таблицы, включая ловушку
+	size_t states_count() const;
+	size_t byte_classes_count() const;
+
+	// номер состояния ДКА, в котором заканчивается разбор слова
+	// (states_count() - 1, если разбор попал в ловушку: слово уже не может быть принято)
+	size_t run(std::string_view) const;
+	bool match(std::string_view) const;
+	// i-й элемент результата - принадлежность языку i-го слова
+	std::vector<bool> match(const std::vector<std::string_view>&) const;
+	// число слов, принадлежащих языку
+	size_t count_matches(const std::vector<std::string_view>&) const;
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "Symbol.h"
+
+class FAState;
+
+// Компактное представление переходов конечного автомата для вычислительно тяжёлых алгоритмов.
+// Символы интернируются в плотные номера: сначала символы алфавита в порядке Alphabet,
+// затем остальные символы, встречающиеся на переходах (например, eps).
+// Переходы хранятся в формате CSR: отсортированные номера состояний, в которые ведут
+// переходы из state по символу symbol, лежат в targets на отрезке
+// [offsets[state * symbols_count() + symbol], offsets[state * symbols_count() + symbol + 1])
+class FATransitionTable {
+  public:
+	using Index = uint32_t;
+
+	// отрезок массива целей переходов
+	class Targets {
+	  private:
+		const Index* first;
+		const Index* last;
+
+	  public:
+		Targets(const Index* first, const Index* last);
+
+		const Index* begin() const;
+		const Index* end() const;
+		size_t size() const;
+		bool empty() const;
+	};
+
+  private:
+	std::vector<Symbol> symbols;
+	std::unordered_map<Symbol, Index, Symbol::Hasher> symbol_index;
+	// номера символов, записываемых одним байтом без разметки
+	std::array<std::optional<Index>, 256> char_index;
+	std::optional<Index> epsilon;
+	size_t alphabet_symbols_count = 0;
+	size_t states_number = 0;
+
+	std::vector<Index> offsets;
+	std::vector<Index> targets;
+
+  public:
+	FATransitionTable() = default;
+	FATransitionTable(const std::vector<FAState>& states, const Alphabet& alphabet);
+
+	size_t states_count() const;
+	size_t symbols_count() const;
+	// символы алфавита занимают номера 0..alphabet_size() - 1
+	size_t alphabet_size() const;
+	size_t transitions_count() const;
+
+	const Symbol& get_symbol(Index symbol) const;
+	std::optional<Index> find_symbol(const Symbol&) const;
+	std::optional<Index> find_symbol(char) const;
+	std::optional<Index> get_epsilon() const;
+
+	Targets get_transitions(int state, Index symbol) const;
+	// i-й элемент - достижимо ли из i-го состояния (по любым переходам) финальное
+	std::vector<bool> get_productive(const std::vector<bool>& is_terminal) const;
+};
+
+// eps-замыкания по таблице переходов: замыкание каждого состояния вычисляется один раз,
+// по требованию, замыкания множеств собираются из них без повторов
+class FAEpsClosures {
+  private:
+	const FATransitionTable& table;
+	std::vector<std::vector<int>> closures;
+	std::vector<bool> is_closure_ready;
+	std::vector<int> closure_stamp;
+	std::vector<int> subset_stamp;
+	int subset_counter = 0;
+
+  public:
+	explicit FAEpsClosures(const FATransitionTable& table);
+
+	// eps-замыкание состояния (в порядке обхода)
+	const std::vector<int>& get_closure(int state);
+	// отсортированное eps-замыкание множества состояний
+	std::vector<int> get_closure(const std::vector<int>& states);
+};
+
+// хеш подмножества состояний, записанного отсортированным вектором номеров
+// или словами битового множества
+struct FASubsetHasher {
+	std::size_t operator()(const std::vector<int>& subset) const;
+	std::size_t operator()(const std::vector<uint64_t>& subset) const;
+};
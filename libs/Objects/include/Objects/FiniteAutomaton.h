@@ -5,10 +5,12 @@
 #include <optional>
 #include <set>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include "AbstractMachine.h"
+#include "FATransitionTable.h"
 #include "iLogTemplate.h"
 
 class Regex;
@@ -48,6 +50,14 @@ class FiniteAutomaton : public AbstractMachine {
 		polynomially_ambigious
 	};
 
+	// способ определения меры неоднозначности
+	enum class AmbiguityMode {
+		// по росту отношения числа путей к числу слов
+		path_counting,
+		// точно, по структуре квадрата и куба автомата (критерии EDA/IDA)
+		structural,
+	};
+
   private:
 	std::vector<FAState> states;
 
@@ -65,13 +75,36 @@ class FiniteAutomaton : public AbstractMachine {
 	std::set<int> closure(const std::set<int>&, bool) const;
 	static bool equality_checker(const FiniteAutomaton& fa1, const FiniteAutomaton& fa2);
 	static bool bisimilarity_checker(const FiniteAutomaton& fa1, const FiniteAutomaton& fa2);
+	// проверка вложенности языка fa1 в язык fa2 антицепями по НКА, без детерминизации;
+	// останавливается на первом контрпримере
+	static bool inclusion_checker(const FiniteAutomaton& fa1, const FiniteAutomaton& fa2);
 	// принимает в качестве лимита максимальное количество цифр в
 	// числителе + знаменателе дроби, которая может встретиться при вычислениях
 	AmbiguityValue get_ambiguity_value(
 		int digits_number_limit,
 		std::optional<int>& word_length) // NOLINT(runtime/references)
 		const;
+	// точная классификация неоднозначности за полиномиальное время: EDA ищется по
+	// компонентам сильной связности квадрата автомата, IDA - по путям в кубе
+	AmbiguityValue get_structural_ambiguity_value() const;
+	// номера компонент сильной связности графа (алгоритм Тарьяна без рекурсии)
+	static std::vector<int> get_strongly_connected_components(
+		const std::vector<std::vector<int>>& graph);
 	std::optional<bool> get_nfa_minimality_value() const;
+	// разбиение состояний ДКА на классы эквивалентности алгоритмом Хопкрофта,
+	// i-й элемент хранит номер класса i-го состояния
+	std::vector<int> get_hopcroft_classes() const;
+	// переходы автомата в виде троек (откуда, метка, куда), номера состояний сдвигаются на offset;
+	// метки символов выдаются через labels, поэтому общий labels даёт общую разметку автоматов
+	static std::vector<std::tuple<int, int, int>> get_labeled_transitions(
+		const FiniteAutomaton&, int offset,
+		std::map<Symbol, int>& labels); // NOLINT(runtime/references)
+	// грубейшая бисимуляция на размеченной системе переходов алгоритмом Пейджа-Тарьяна
+	// за O(m log n), начальное разбиение задаётся initial_classes; классы нумеруются
+	// в порядке первого появления
+	static std::vector<int> get_bisimulation_classes(
+		int states_number, const std::vector<std::tuple<int, int, int>>& transitions,
+		const std::vector<int>& initial_classes);
 
 	// поиск префикса из состояния state_beg в состояние state_end
 	std::optional<std::string> get_prefix(
@@ -80,6 +113,11 @@ class FiniteAutomaton : public AbstractMachine {
 	// функция проверки на семантическую детерминированность
 	bool semdet_entry(bool annoted = false, iLogTemplate* log = nullptr) const;
 
+	// произведение автоматов: создаются только достижимые из начальной пары состояний,
+	// is_terminal определяет терминальность пары по терминальности её компонент
+	static FiniteAutomaton get_product(const FiniteAutomaton&, const FiniteAutomaton&,
+									   const Alphabet&, bool (*is_terminal)(bool, bool));
+
 	// меняет местами состояние под индексом 0 с начальным
 	// используется в томпсоне
 	void set_initial_state_to_zero();
@@ -97,6 +135,8 @@ class FiniteAutomaton : public AbstractMachine {
 	std::string to_txt() const override;
 
 	std::vector<FAState> get_states() const;
+	// компактная таблица переходов (CSR) для вычислительно тяжёлых алгоритмов
+	FATransitionTable get_transition_table() const;
 	size_t size(iLogTemplate* log = nullptr) const override;
 
 	// детерминизация ДКА
@@ -146,6 +186,10 @@ class FiniteAutomaton : public AbstractMachine {
 	// проверка автоматов на эквивалентность
 	static bool equivalent(const FiniteAutomaton&, const FiniteAutomaton&,
 						   iLogTemplate* log = nullptr);
+	// кратчайшее слово, принадлежащее ровно одному из языков автоматов
+	// (nullopt, если языки совпадают)
+	static std::optional<std::vector<Symbol>> get_distinguishing_word(const FiniteAutomaton&,
+																	  const FiniteAutomaton&);
 	// проверка автоматов на равенство(буквальное)
 	static bool equal(const FiniteAutomaton&, const FiniteAutomaton&, iLogTemplate* log = nullptr);
 	// проверка автоматов на бисимилярность
@@ -159,6 +203,7 @@ class FiniteAutomaton : public AbstractMachine {
 	bool subset(const FiniteAutomaton&, iLogTemplate* log = nullptr) const;
 	// определяет меру неоднозначности
 	AmbiguityValue ambiguity(iLogTemplate* log = nullptr) const;
+	AmbiguityValue ambiguity(AmbiguityMode mode, iLogTemplate* log = nullptr) const;
 	// проверка на детерминированность методом орбит Брюггеманн-Вуда
 	bool is_one_unambiguous(iLogTemplate* log = nullptr) const;
 	// проверка на пустоту
@@ -181,4 +226,9 @@ class FiniteAutomaton : public AbstractMachine {
 	friend class MetaInfo;
 	friend class RLGrammar;
 	friend class PrefixGrammar;
+	friend class DFAMatcher;
+	friend class LazyDFAMatcher;
+	friend class BitParallelMatcher;
+	friend class MultiPatternMatcher;
+	friend class PathCounter;
 };
\ No newline at end of file
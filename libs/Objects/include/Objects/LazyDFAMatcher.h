@@ -0,0 +1,73 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "FATransitionTable.h"
+#include "StreamMatcher.h"
+
+class FiniteAutomaton;
+
+// Ленивый ДКА для проверки принадлежности слов языку НКА (в том числе с eps-переходами).
+// Состояния ДКА - eps-замкнутые множества состояний НКА - строятся по требованию во время
+// разбора и кэшируются вместе с уже вычисленными переходами, так что состояния, до которых
+// вход не доходит, не строятся вовсе. Когда оценка занятой кэшем памяти превышает лимит,
+// кэш сбрасывается целиком и заполняется заново с текущего состояния.
+// match() разбирает слово целиком через reset()/feed()/finish(), прерывая текущий поток.
+// Символы автомата, не записываемые одним байтом без разметки, при разборе не используются.
+class LazyDFAMatcher : public StreamMatcher {
+  private:
+	// отсутствующий в кэше переход
+	static constexpr int unknown = -1;
+
+	FATransitionTable table;
+	FAEpsClosures closures;
+	std::vector<bool> is_terminal;
+	// из состояния НКА достижимо финальное
+	std::vector<bool> is_productive;
+	std::vector<int> initial_subset;
+	std::array<std::optional<FATransitionTable::Index>, 256> byte_symbol;
+	size_t symbols_number;
+	size_t memory_limit;
+
+	// кэш: подмножества хранятся в ключах index_by_subset
+	std::unordered_map<std::vector<int>, int, FASubsetHasher> index_by_subset;
+	std::vector<const std::vector<int>*> subset_by_index;
+	std::vector<bool> is_accepting;
+	// подмножество содержит продуктивное состояние НКА
+	std::vector<bool> is_live;
+	// переходы ДКА: next[state * symbols_number + symbol]
+	std::vector<int> next;
+	size_t memory_used = 0;
+	int initial_index = unknown;
+	size_t flushes_number = 0;
+	// текущее состояние потокового разбора; unknown - слово уже не может быть принято
+	int current = unknown;
+
+	void flush();
+	int add_state(std::vector<int>&& subset);
+	int get_next(int state, FATransitionTable::Index symbol);
+
+  public:
+	// memory_limit - ограничение на оценку памяти кэша в байтах
+	explicit LazyDFAMatcher(const FiniteAutomaton&, size_t memory_limit = 8 << 20);
+	// closures ссылается на table
+	LazyDFAMatcher(const LazyDFAMatcher&) = delete;
+	LazyDFAMatcher& operator=(const LazyDFAMatcher&) = delete;
+
+	void reset() override;
+	bool feed(std::string_view chunk) override;
+	bool finish() const override;
+
+	bool match(std::string_view);
+	// i-й элемент результата - принадлежность языку i-го слова
+	std::vector<bool> match(const std::vector<std::string_view>&);
+
+	// число состояний ДКА, находящихся в кэше
+	size_t cached_states_count() const;
+	// сколько раз кэш сбрасывался из-за лимита памяти
+	size_t flushes_count() const;
+};
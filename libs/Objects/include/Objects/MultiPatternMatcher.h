@@ -0,0 +1,39 @@
+#pragma once
+#include <string_view>
+#include <vector>
+
+#include "DFAMatcher.h"
+
+class FiniteAutomaton;
+class Regex;
+
+// Одновременная проверка слова на принадлежность языкам многих шаблонов за один проход.
+// Автоматы шаблонов объединяются через новое начальное состояние с eps-переходами в их
+// начальные состояния и детерминизируются; каждое состояние ДКА хранит множество номеров
+// шаблонов, финальные состояния которых входят в его подмножество. Разбор идёт по
+// скомпилированной таблице DFAMatcher.
+class MultiPatternMatcher {
+  private:
+	DFAMatcher matcher;
+	size_t patterns_number;
+	// отсортированные номера шаблонов, принимающих слово, разбор которого закончился
+	// в данном состоянии (последнее состояние - ловушка)
+	std::vector<std::vector<int>> patterns_by_state;
+
+	MultiPatternMatcher(const FiniteAutomaton& dfa, size_t patterns_number,
+						std::vector<std::vector<int>> patterns_by_state);
+	static MultiPatternMatcher compile(const std::vector<FiniteAutomaton>&);
+
+  public:
+	explicit MultiPatternMatcher(const std::vector<FiniteAutomaton>&);
+	// регулярки переводятся в автоматы Глушкова
+	explicit MultiPatternMatcher(const std::vector<Regex>&);
+
+	size_t patterns_count() const;
+	size_t states_count() const;
+
+	// номера шаблонов (в порядке возрастания), языкам которых принадлежит слово
+	const std::vector<int>& match(std::string_view) const;
+	// i-й элемент результата - номера шаблонов для i-го слова
+	std::vector<std::vector<int>> match(const std::vector<std::string_view>&) const;
+};
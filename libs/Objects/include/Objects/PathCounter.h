@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Fraction/InfInt.h"
+
+class FiniteAutomaton;
+
+// Подсчёт числа путей длины 1, 2, ... из начального состояния автомата в финальные.
+// Матрица смежности хранится в разреженном виде (CSR по исходным состояниям, с
+// кратностями рёбер), на каждом шаге обходятся только состояния с ненулевым числом путей.
+// Пока значения помещаются в uint64_t, счёт идёт в машинных словах с проверкой
+// переполнения; при первом переполнении шаг повторяется в длинной арифметике,
+// и дальше счёт ведётся только в ней.
+// eps-переходы считаются обычными рёбрами, поэтому их нужно удалить заранее.
+class PathCounter {
+  private:
+	std::vector<int> edges_begin;
+	std::vector<int> edge_target;
+	std::vector<uint64_t> edge_multiplicity;
+	std::vector<bool> is_terminal;
+
+	bool is_big = false;
+	std::vector<uint64_t> counts, next_counts;
+	std::vector<InfInt> big_counts, next_big_counts;
+
+	// false, если шаг переполнил uint64_t (counts при этом не меняются)
+	bool next_small(uint64_t& paths_number); // NOLINT(runtime/references)
+	InfInt next_big();
+
+  public:
+	explicit PathCounter(const FiniteAutomaton&);
+
+	// переходит к путям на единицу длиннее и возвращает число путей
+	// этой длины, заканчивающихся в финальных состояниях
+	InfInt next();
+	// true, если счёт уже перешёл на длинную арифметику
+	bool is_using_big_integers() const;
+};
@@ -19,22 +19,14 @@ class Regex : public AlgExpression {
 	// возвращает указатель на new Regex
 	Regex* make() const override;
 
-	Regex* expr(const std::vector<Lexeme>&, int, int) override;
-	Regex* scan_minus(const std::vector<Lexeme>&, int, int);
-
 	bool equals(const AlgExpression* other) const override;
 
 	// Множество префиксов длины len
 	void get_prefix(int len, std::set<std::string>& prefs) const; // NOLINT(runtime/references)
-	// Производная по символу
-	bool derivative_with_respect_to_sym(Regex* respected_sym, const Regex* reg_e,
-										Regex& result) const; // NOLINT(runtime/references)
+	// Частная производная по символу
 	bool partial_derivative_with_respect_to_sym(
 		Regex* respected_sym, const Regex* reg_e,
 		std::vector<Regex>& result) const; // NOLINT(runtime/references)
-	// Производная по префиксу
-	bool derivative_with_respect_to_str(std::string str, const Regex* reg_e,
-										Regex& result) const; // NOLINT(runtime/references)
 	// применение ACI правил
 	static Regex* to_aci(std::vector<Regex>& res); // NOLINT(runtime/references)
 	static Regex* add_alt(std::vector<Regex> res, Regex* root);
@@ -45,8 +37,16 @@ class Regex : public AlgExpression {
 	// возвращает вектор листьев дерева
 	std::vector<Regex*> preorder_traversal();
 	bool contains_eps() const override;
-	// для каждой ноды возвращает множество номеров нод, которым она может предшествовать
-	std::unordered_map<int, std::vector<int>> get_follow() const;
+	// позиционный автомат: позиции - листья-символы, пронумерованные слева направо
+	struct Positions {
+		std::vector<Symbol> symbols;		  // символ в каждой позиции
+		std::vector<int> first;				  // позиции, с которых может начинаться слово
+		std::vector<int> last;				  // позиции, которыми может заканчиваться слово
+		std::vector<std::vector<int>> follow; // follow[i] - позиции, которые могут следовать за i
+		bool nullable = false;
+	};
+	// один проход снизу вверх: nullable/first/last вычисляются для каждой ноды один раз
+	Positions get_positions() const;
 
 	void normalize_this_regex(
 		const std::vector<std::pair<Regex, Regex>>&); // переписывание regex по
@@ -60,7 +60,9 @@ class Regex : public AlgExpression {
 
 	Regex* make_copy() const override;
 	Regex(const Regex&) = default;
+	Regex(Regex&&) noexcept = default;
 	Regex& operator=(const Regex& other);
+	Regex& operator=(Regex&& other) noexcept;
 
 	// dynamic_cast к типу Regex*
 	template <typename T> static Regex* cast(T* ptr, bool not_null_ptr = true);
@@ -73,6 +75,12 @@ class Regex : public AlgExpression {
 	FiniteAutomaton to_glushkov(iLogTemplate* log = nullptr) const;
 	FiniteAutomaton to_ilieyu(iLogTemplate* log = nullptr) const;
 	FiniteAutomaton to_antimirov(iLogTemplate* log = nullptr) const;
+	// ДКА производных Бжозовского: состояния - канонические (ACI) производные выражения
+	FiniteAutomaton to_brzozowski(iLogTemplate* log = nullptr) const;
+	// ДКА позиций (followpos): состояния - битовые множества позиций, строится прямо по
+	// first/follow без автомата Глушкова и совпадает с to_glushkov().determinize();
+	// is_minimized - дополнительно минимизировать алгоритмом Хопкрофта
+	FiniteAutomaton to_dfa(bool is_minimized = false, iLogTemplate* log = nullptr) const;
 	// проверка регулярок на равенство (пока работает только для стандартного построения)
 	static bool equal(const Regex&, const Regex&, iLogTemplate* log = nullptr);
 	// проверка регулярок на эквивалентность
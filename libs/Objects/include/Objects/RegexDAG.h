@@ -0,0 +1,51 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+#include "Regex.h"
+
+// Хранилище регулярных выражений в виде DAG с хэш-консингом: структурно равные
+// подвыражения хранятся один раз и получают один номер. Сравнение и хэширование
+// выражений сводятся к сравнению номеров, а общие поддеревья не копируются -
+// дерево Regex строится только по запросу to_regex.
+class RegexDAG {
+  public:
+	using Type = AlgExpression::Type;
+
+	struct Node {
+		Type type;
+		Symbol symbol;
+		// номера дочерних узлов, -1 - отсутствует
+		int term_l;
+		int term_r;
+
+		bool operator==(const Node& other) const;
+	};
+
+	// номер выражения, структурно равного дереву
+	int add(const Regex&);
+	// номер узла с заданным типом и потомками (символ пустой)
+	int add(Type type, int term_l = -1, int term_r = -1);
+	int eps();
+	int symb(const Symbol&);
+	int alt(int term_l, int term_r);
+	int conc(int term_l, int term_r);
+	int star(int term);
+
+	const Node& get_node(int) const;
+	// число различных подвыражений
+	int size() const;
+	// разворачивает выражение в дерево (общие поддеревья копируются) с языком по его алфавиту
+	Regex to_regex(int) const;
+
+  private:
+	struct Hasher {
+		std::size_t operator()(const Node&) const;
+	};
+
+	std::vector<Node> nodes;
+	std::unordered_map<Node, int, Hasher> index;
+
+	int intern(const Node&);
+	void build(int, Regex*) const;
+};
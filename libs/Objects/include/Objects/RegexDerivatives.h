@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "RegexDAG.h"
+
+// Производные Бжозовского над выражениями, хранящимися в RegexDAG.
+// Выражения приводятся к каноническому виду: альтернатива - правоассоциативная цепочка
+// различных слагаемых, упорядоченных по номерам (правила ACI, как в Regex::to_aci),
+// пустое множество и eps поглощаются, конкатенация правоассоциативна. Благодаря
+// хэш-консингу подобные производные получают один номер, поэтому их число конечно,
+// а вычисленные производные запоминаются в таблице (номер выражения, символ).
+class RegexDerivatives {
+  public:
+	using Type = RegexDAG::Type;
+
+	RegexDerivatives();
+
+	// номер канонической формы выражения
+	int add(const Regex&);
+	// номер пустого множества
+	int empty_set() const;
+	// производная выражения по символу (empty_set(), если она пуста)
+	int derivative(int id, const Symbol&);
+	// производная выражения по слову, каждый символ строки - буква
+	int prefix_derivative(int id, const std::string&);
+	// содержит ли язык выражения пустое слово
+	bool contains_eps(int id);
+	// разворачивает выражение в дерево (для empty_set() - символ Symbol::EmptySet)
+	Regex to_regex(int id) const;
+	// число различных выражений в хранилище
+	int size() const;
+
+  private:
+	RegexDAG dag;
+	int empty;
+	// канонические формы узлов, добавленных через add
+	std::unordered_map<int, int> normalized;
+	// содержит ли выражение пустое слово: -1 - не вычислено
+	std::vector<signed char> nullable;
+	std::unordered_map<Symbol, int, Symbol::Hasher> symbol_ids;
+	// derivatives[номер символа][номер выражения], -1 - не вычислено
+	std::vector<std::vector<int>> derivatives;
+
+	int normalize(int);
+	int alt(int, int);
+	int conc(int, int);
+	int star(int);
+	// слагаемые канонической альтернативы в порядке возрастания номеров
+	void get_alternatives(int, std::vector<int>&) const; // NOLINT(runtime/references)
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Потоковая проверка принадлежности слова языку: слово подаётся фрагментами,
+// так что целиком в памяти оно не нужно.
+//	reset() - начало нового слова;
+//	feed(chunk) - очередной фрагмент слова;
+//	finish() - принадлежит ли языку слово, поданное с последнего reset().
+class StreamMatcher {
+  protected:
+	size_t consumed = 0;
+
+  public:
+	struct Result {
+		bool accepted;
+		// сколько байт прочитано до ответа: при досрочном отказе - до байта,
+		// после которого слово уже не может быть принято, включительно
+		size_t bytes_consumed;
+	};
+
+	virtual ~StreamMatcher() = default;
+
+	virtual void reset() = 0;
+	// возвращает false, если слово уже не может быть принято;
+	// дальнейшие фрагменты до reset() игнорируются
+	virtual bool feed(std::string_view chunk) = 0;
+	virtual bool finish() const = 0;
+
+	// сколько байт слова прочитано с последнего reset()
+	size_t bytes_consumed() const;
+
+	// прогоняет содержимое файла через matcher без копирования: файл отображается в память
+	// (на Windows читается блоками)
+	static Result match_file(StreamMatcher& matcher, // NOLINT(runtime/references)
+							 const std::string& path);
+};
@@ -30,6 +30,7 @@ class Symbol {
 	Symbol(char c);				  // NOLINT(runtime/explicit)
 
 	Symbol(const Symbol& other) = default;
+	Symbol(Symbol&& other) noexcept = default;
 
 	static Symbol Ref(int number);
 
@@ -37,6 +38,7 @@ class Symbol {
 	Symbol& operator=(const char* c);
 	Symbol& operator=(char c);
 	Symbol& operator=(const Symbol& other) = default;
+	Symbol& operator=(Symbol&& other) noexcept = default;
 	// многие функции все еще работают с символами алфавита, как со строками
 	// для них добавлено преобразование типов
 	operator std::string() const;
@@ -1,3 +1,6 @@
+#include <atomic>
+#include <cstdint>
+#include <new>
 #include <stack>
 #include <unordered_map>
 #include <unordered_set>
@@ -23,9 +26,8 @@ AlgExpression::AlgExpression() {
 AlgExpression::Lexeme::Lexeme(Type type, const Symbol& symbol, int number)
 	: type(type), symbol(symbol), number(number) {}
 
-AlgExpression::AlgExpression(std::shared_ptr<Language> language, Type type, const Symbol& symbol,
-							 Alphabet alphabet)
-	: BaseObject(std::move(language)), type(type), symbol(symbol), alphabet(std::move(alphabet)) {}
+AlgExpression::AlgExpression(std::shared_ptr<Language> language, Type type, const Symbol& symbol)
+	: BaseObject(std::move(language)), type(type), symbol(symbol) {}
 
 AlgExpression::AlgExpression(Type type, const Symbol& symbol) : type(type), symbol(symbol) {}
 
@@ -33,24 +35,32 @@ AlgExpression::AlgExpression(Alphabet alphabet) : BaseObject(std::move(alphabet)
 
 AlgExpression::AlgExpression(Type type, AlgExpression* _term_l, AlgExpression* _term_r)
 	: type(type) {
-	if (_term_l) {
+	if (_term_l)
 		term_l = _term_l->make_copy();
-		alphabet = term_l->alphabet;
-	}
-	if (_term_r) {
+	if (_term_r)
 		term_r = _term_r->make_copy();
-		alphabet.insert(term_r->alphabet.begin(), term_r->alphabet.end());
-	}
 }
 
 void AlgExpression::clear() {
-	if (term_l) {
-		delete term_l;
-		term_l = nullptr;
-	}
-	if (term_r) {
-		delete term_r;
-		term_r = nullptr;
+	// поддеревья удаляются без рекурсии: у узла дети отцепляются до его удаления,
+	// поэтому деструктор узла уже ничего не обходит
+	vector<AlgExpression*> nodes;
+	if (term_l)
+		nodes.push_back(term_l);
+	if (term_r)
+		nodes.push_back(term_r);
+	term_l = nullptr;
+	term_r = nullptr;
+	while (!nodes.empty()) {
+		AlgExpression* node = nodes.back();
+		nodes.pop_back();
+		if (node->term_l)
+			nodes.push_back(node->term_l);
+		if (node->term_r)
+			nodes.push_back(node->term_r);
+		node->term_l = nullptr;
+		node->term_r = nullptr;
+		delete node;
 	}
 }
 
@@ -58,8 +68,189 @@ AlgExpression::~AlgExpression() {
 	clear();
 }
 
+namespace {
+// пул узлов: блоки нарезаются из выровненных страниц своего потока и после освобождения
+// попадают в список свободных блоков своего размера. Блок, освобождённый в чужом потоке,
+// кладётся в список удалённо освобождённых блоков своей страницы; поток-владелец забирает
+// эти блоки в свои списки, прежде чем выделить новую страницу. Страницы освобождаются
+// при завершении потока-владельца: пустые сразу, остальные вместе с последним узлом
+struct NodePool {
+	static const std::size_t granularity = 16;
+	static const std::size_t max_size = 512;
+	static const std::size_t page_size = 64 << 10;
+	// старший бит состояния страницы: пул-владелец уничтожен
+	static const std::size_t orphaned = ~(~std::size_t(0) >> 1);
+
+	// заголовок страницы, блоки идут сразу за ним
+	struct alignas(granularity) Page {
+		NodePool* owner;
+		// число живых блоков и бит orphaned
+		std::atomic<std::size_t> state;
+		// блоки, освобождённые в чужих потоках
+		std::atomic<void*> remote_free;
+
+		Page(NodePool* owner, std::size_t state)
+			: owner(owner), state(state), remote_free(nullptr) {}
+	};
+
+	// свободный блок: ссылка на следующий и номер размера (нужен для удалённых списков)
+	struct FreeBlock {
+		void* next;
+		std::size_t slot;
+	};
+
+	void* free_lists[max_size / granularity] = {};
+	std::vector<Page*> pages;
+	char* next = nullptr;
+	std::size_t page_left = 0;
+
+	static Page* page_of(void* block) {
+		return reinterpret_cast<Page*>(reinterpret_cast<std::uintptr_t>(block) &
+									   ~(page_size - 1));
+	}
+
+	static Page* new_page(NodePool* owner, std::size_t size, std::size_t state) {
+		void* memory = ::operator new(size, std::align_val_t(page_size));
+		return new (memory) Page(owner, state);
+	}
+
+	static void free_page(Page* page) {
+		page->~Page();
+		::operator delete(page, std::align_val_t(page_size));
+	}
+
+	// выделение после уничтожения пула потока (например, при удалении статических объектов):
+	// узел получает собственную страницу, которая освободится вместе с ним
+	static void* allocate_orphaned(std::size_t size) {
+		if (size == 0 || size > max_size)
+			return ::operator new(size);
+		std::size_t block_size = ((size - 1) / granularity + 1) * granularity;
+		return new_page(nullptr, sizeof(Page) + block_size, orphaned + 1) + 1;
+	}
+
+	// освобождение блока чужого пула или после уничтожения своего
+	static void deallocate_remote(void* block, std::size_t size) {
+		if (size == 0 || size > max_size) {
+			::operator delete(block);
+			return;
+		}
+		Page* page = page_of(block);
+		FreeBlock* free_block = static_cast<FreeBlock*>(block);
+		free_block->slot = (size - 1) / granularity;
+		free_block->next = page->remote_free.load(std::memory_order_relaxed);
+		while (!page->remote_free.compare_exchange_weak(
+			free_block->next, block, std::memory_order_release, std::memory_order_relaxed)) {
+		}
+		// после уменьшения счётчика страница может быть освобождена, поэтому блок
+		// кладётся в список до него
+		if (page->state.fetch_sub(1, std::memory_order_acq_rel) == orphaned + 1)
+			free_page(page);
+	}
+
+	// переносит блоки, освобождённые в чужих потоках, в свои списки свободных
+	void collect_remote() {
+		for (Page* page : pages) {
+			if (!page->remote_free.load(std::memory_order_relaxed))
+				continue;
+			void* block = page->remote_free.exchange(nullptr, std::memory_order_acquire);
+			while (block) {
+				FreeBlock* free_block = static_cast<FreeBlock*>(block);
+				void* next_block = free_block->next;
+				free_block->next = free_lists[free_block->slot];
+				free_lists[free_block->slot] = block;
+				block = next_block;
+			}
+		}
+	}
+
+	void* allocate(std::size_t size) {
+		if (size == 0 || size > max_size)
+			return ::operator new(size);
+		std::size_t slot = (size - 1) / granularity;
+		std::size_t block_size = (slot + 1) * granularity;
+		if (!free_lists[slot] && page_left < block_size)
+			collect_remote();
+		void* block = free_lists[slot];
+		if (block) {
+			free_lists[slot] = static_cast<FreeBlock*>(block)->next;
+		} else {
+			if (page_left < block_size) {
+				Page* page = new_page(this, page_size, 0);
+				pages.push_back(page);
+				next = reinterpret_cast<char*>(page + 1);
+				page_left = page_size - sizeof(Page);
+			}
+			block = next;
+			next += block_size;
+			page_left -= block_size;
+		}
+		page_of(block)->state.fetch_add(1, std::memory_order_relaxed);
+		return block;
+	}
+
+	void deallocate(void* block, std::size_t size) {
+		if (size == 0 || size > max_size) {
+			::operator delete(block);
+			return;
+		}
+		Page* page = page_of(block);
+		// страница уничтоженного пула могла остаться с тем же адресом владельца
+		if (page->owner != this || (page->state.load(std::memory_order_relaxed) & orphaned)) {
+			deallocate_remote(block, size);
+			return;
+		}
+		std::size_t slot = (size - 1) / granularity;
+		static_cast<FreeBlock*>(block)->next = free_lists[slot];
+		free_lists[slot] = block;
+		page->state.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	~NodePool();
+};
+
+// флаг хранится отдельно от пула: после деструктора пула к нему обращаться нельзя
+thread_local bool is_node_pool_destroyed = false;
+thread_local NodePool node_pool;
+
+NodePool::~NodePool() {
+	is_node_pool_destroyed = true;
+	for (Page* page : pages)
+		if (page->state.fetch_or(orphaned, std::memory_order_acq_rel) == 0)
+			free_page(page);
+}
+} // namespace
+
+void* AlgExpression::operator new(std::size_t size) {
+	if (is_node_pool_destroyed)
+		return NodePool::allocate_orphaned(size);
+	return node_pool.allocate(size);
+}
+
+void AlgExpression::operator delete(void* ptr, std::size_t size) {
+	if (!ptr)
+		return;
+	if (is_node_pool_destroyed)
+		NodePool::deallocate_remote(ptr, size);
+	else
+		node_pool.deallocate(ptr, size);
+}
+
+AlgExpression::AlgExpression(AlgExpression&& other) noexcept : AlgExpression() {
+	move_from(other);
+}
+
+void AlgExpression::move_from(AlgExpression& other) noexcept {
+	type = other.type;
+	symbol = std::move(other.symbol);
+	language = std::move(other.language);
+	term_l = other.term_l;
+	term_r = other.term_r;
+	other.term_l = nullptr;
+	other.term_r = nullptr;
+	other.type = Type::eps;
+}
+
 AlgExpression::AlgExpression(const AlgExpression& other) : AlgExpression() {
-	alphabet = other.alphabet;
 	type = other.type;
 	symbol = other.symbol;
 	language = other.language;
@@ -86,33 +277,37 @@ AlgExpression* AlgExpression::get_term_r() const {
 }
 
 void AlgExpression::set_language(const Alphabet& _alphabet) {
-	alphabet = _alphabet;
-	language = make_shared<Language>(alphabet);
+	language = make_shared<Language>(_alphabet);
 }
 
 void AlgExpression::set_language(const std::shared_ptr<Language>& _language) {
 	language = _language;
 }
 
-void AlgExpression::generate_alphabet() {
-	if (type == AlgExpression::symb) {
-		alphabet = {symbol};
-		return;
-	}
-	alphabet.clear();
-	if (term_l) {
-		term_l->generate_alphabet();
-		alphabet = term_l->alphabet;
-	}
-	if (term_r) {
-		term_r->generate_alphabet();
-		alphabet.insert(term_r->alphabet.begin(), term_r->alphabet.end());
+Alphabet AlgExpression::generate_alphabet() const {
+	Alphabet alphabet;
+	vector<const AlgExpression*> nodes = {this};
+	while (!nodes.empty()) {
+		const AlgExpression* node = nodes.back();
+		nodes.pop_back();
+		if (node->type == AlgExpression::symb)
+			alphabet.insert(node->symbol);
+		if (node->term_l)
+			nodes.push_back(node->term_l);
+		if (node->term_r)
+			nodes.push_back(node->term_r);
 	}
+	return alphabet;
 }
 
 void AlgExpression::make_language() {
-	generate_alphabet();
-	language = make_shared<Language>(alphabet);
+	language = make_shared<Language>(generate_alphabet());
+}
+
+std::shared_ptr<Language> AlgExpression::get_or_make_language() const {
+	if (language)
+		return language;
+	return make_shared<Language>(generate_alphabet());
 }
 
 bool AlgExpression::is_terminal_type(Type t) {
@@ -279,14 +474,20 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 
 	bool regex_is_eps = true;
 	auto is_symbol = [](char c) { return c >= 'a' && c <= 'z' || c >= 'A' && c <= 'Z'; };
+	auto error = [](size_t position) {
+		Lexeme lexeme(Lexeme::Type::error);
+		lexeme.position = position;
+		return vector<Lexeme>{lexeme};
+	};
 
 	for (size_t index = 0; index < str.size(); index++) {
 		char c = str[index];
 		Lexeme lexeme;
+		lexeme.position = index;
 		switch (c) {
 		case '^':
 			if (!allow_negation)
-				return {Lexeme::Type::error};
+				return error(index);
 
 			lexeme.type = Lexeme::Type::negative;
 			break;
@@ -298,13 +499,13 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 		case ')':
 			lexeme.type = Lexeme::Type::parR;
 			if (brackets_are_empty || brackets_checker.empty() || brackets_checker.top() != '(')
-				return {Lexeme::Type::error};
+				return error(index);
 
 			brackets_checker.pop();
 			break;
 		case '[':
 			if (!allow_ref)
-				return {Lexeme::Type::error};
+				return error(index);
 
 			lexeme.type = Lexeme::Type::squareBrL;
 			brackets_checker.push('[');
@@ -312,15 +513,15 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 			break;
 		case ']':
 			if (brackets_are_empty || brackets_checker.empty() || brackets_checker.top() != '[')
-				return {Lexeme::Type::error};
+				return error(index);
 			brackets_checker.pop();
 
 			index++;
 			if (index >= str.size() && str[index] != ':')
-				return {Lexeme::Type::error};
+				return error(index);
 
 			if (!read_number(str, ++index, lexeme.number))
-				return {Lexeme::Type::error};
+				return error(index);
 
 			lexeme.type = Lexeme::Type::squareBrR;
 			lexemes[memory_opening_indexes.top()].number = lexeme.number;
@@ -328,10 +529,10 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 			break;
 		case '&':
 			if (!allow_ref)
-				return {Lexeme::Type::error};
+				return error(index);
 
 			if (!read_number(str, ++index, lexeme.number))
-				return {Lexeme::Type::error};
+				return error(index);
 
 			lexeme.type = Lexeme::Type::ref;
 			// не будет входить в алфавит, нужно только для обозначения перехода в MFA
@@ -341,7 +542,7 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 			break;
 		case '|':
 			if (index != 0 && lexemes.back().type == Lexeme::Type::negative)
-				return {Lexeme::Type::error};
+				return error(index);
 
 			lexeme.type = Lexeme::Type::alt;
 			break;
@@ -349,7 +550,7 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 			if (index == 0 || (index != 0 && (lexemes.back().type == Lexeme::Type::star ||
 											  lexemes.back().type == Lexeme::Type::alt ||
 											  lexemes.back().type == Lexeme::Type::negative)))
-				return {Lexeme::Type::error};
+				return error(index);
 
 			lexeme.type = Lexeme::Type::star;
 			break;
@@ -371,7 +572,7 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 
 					int number;
 					if (!read_number(str, ++j, number))
-						return {Lexeme::Type::error};
+						return error(index);
 					index = j;
 
 					if (lin)
@@ -384,7 +585,7 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 				regex_is_eps = false;
 				brackets_are_empty = false;
 			} else {
-				return {Lexeme::Type::error};
+				return error(index);
 			}
 			break;
 		}
@@ -404,6 +605,7 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 				lexeme.type == Lexeme::Type::negative)) {
 			// We place . between
 			lexemes.emplace_back(Lexeme::Type::conc);
+			lexemes.back().position = index;
 		}
 
 		if (!lexemes.empty() &&
@@ -416,6 +618,7 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 			   lexeme.type == Lexeme::Type::alt)))) {
 			//  We place eps between
 			lexemes.emplace_back(Lexeme::Type::eps);
+			lexemes.back().position = index;
 		}
 
 		if (lexeme.type == Lexeme::Type::squareBrL) {
@@ -426,7 +629,7 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 	}
 
 	if (regex_is_eps || !brackets_checker.empty())
-		return {Lexeme::Type::error};
+		return error(str.size());
 
 	// проверка на отсутствие вложенных захватов памяти для одной ячейки
 	std::unordered_set<int> opened_memory_cells;
@@ -434,7 +637,7 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 		switch (l.type) {
 		case Lexeme::Type::squareBrL:
 			if (opened_memory_cells.count(l.number))
-				return {Lexeme::Type::error};
+				return error(l.position);
 			opened_memory_cells.insert(l.number);
 			break;
 		case Lexeme::Type::squareBrR:
@@ -442,7 +645,7 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 			break;
 		case Lexeme::Type::ref:
 			if (opened_memory_cells.count(l.number))
-				return {Lexeme::Type::error};
+				return error(l.position);
 		default:
 			break;
 		}
@@ -454,165 +657,184 @@ vector<AlgExpression::Lexeme> AlgExpression::parse_string(string str, bool allow
 
 	if (lexemes.back().type == Lexeme::Type::alt || lexemes.back().type == Lexeme::Type::negative) {
 		lexemes.emplace_back(Lexeme::Type::eps);
+		lexemes.back().position = str.size();
 	}
 
 	return lexemes;
 }
 
-bool AlgExpression::from_string(const string& str, bool allow_ref, bool allow_negation) {
+bool AlgExpression::from_string(const string& str, size_t& error_position, bool allow_ref,
+								bool allow_negation) {
 	if (str.empty()) {
 		symbol = Lexeme::Type::eps;
 		type = Type::eps;
-		alphabet = {};
-		language = make_shared<Language>(alphabet);
+		language = make_shared<Language>(Alphabet());
 		return true;
 	}
 
 	vector<Lexeme> l = parse_string(str, allow_ref, allow_negation);
-	AlgExpression* root = expr(l, 0, l.size());
+	AlgExpression* root = expr(l, error_position);
 
 	if (root == nullptr || root->type == eps) {
+		if (root)
+			error_position = 0;
 		delete root;
 		return false;
 	}
 
-	copy(root);
-	language = make_shared<Language>(alphabet);
-
+	// корень разобранного дерева забирается без копирования поддеревьев
+	move_from(*root);
 	delete root;
+	make_language();
 	return true;
 }
 
-void AlgExpression::update_balance(const AlgExpression::Lexeme& l, int& balance) {
-	if (l.type == Lexeme::Type::parL || l.type == Lexeme::Type::squareBrL) {
-		balance++;
-	}
-	if (l.type == Lexeme::Type::parR || l.type == Lexeme::Type::squareBrR) {
-		balance--;
-	}
+AlgExpression* AlgExpression::make_node(Type node_type, const Lexeme& lexeme) const {
+	AlgExpression* p = make();
+	p->type = node_type;
+	if (node_type == Type::symb || node_type == Type::ref)
+		p->symbol = lexeme.symbol;
+	if (node_type == Type::eps)
+		p->symbol = Symbol::Epsilon;
+	return p;
 }
 
-AlgExpression* AlgExpression::scan_conc(const vector<AlgExpression::Lexeme>& lexemes,
-										int index_start, int index_end) {
-	AlgExpression* p = nullptr;
-	int balance = 0;
-	for (int i = index_start; i < index_end; i++) {
-		update_balance(lexemes[i], balance);
-		if (lexemes[i].type == Lexeme::Type::conc && balance == 0) {
-			AlgExpression* l = expr(lexemes, index_start, i);
-			AlgExpression* r = expr(lexemes, i + 1, index_end);
-			if (l == nullptr || r == nullptr || r->type == AlgExpression::eps ||
-				l->type == AlgExpression::eps) { // Проверка на адекватность)
-				delete r;
-				delete l;
-				return p;
-			}
+AlgExpression* AlgExpression::expr(const vector<AlgExpression::Lexeme>& lexemes,
+								   size_t& error_position) const {
+	// сила связывания операторов; скобки лежат на стеке операторов с приоритетом 0
+	auto priority = [](Lexeme::Type t) {
+		switch (t) {
+		case Lexeme::Type::alt:
+			return 1;
+		case Lexeme::Type::conc:
+			return 2;
+		case Lexeme::Type::negative:
+			return 3;
+		default:
+			return 0;
+		}
+	};
 
-			p = make();
-			p->term_l = l;
-			p->term_r = r;
-			p->symbol = lexemes[i].symbol;
-			p->type = Type::conc;
+	vector<AlgExpression*> operands;
+	vector<const Lexeme*> operators;
 
-			p->alphabet = l->alphabet;
-			p->alphabet.insert(r->alphabet.begin(), r->alphabet.end());
-			return p;
+	auto fail = [&](size_t position) -> AlgExpression* {
+		error_position = position;
+		for (AlgExpression* p : operands)
+			delete p;
+		return nullptr;
+	};
+	// применяет верхний оператор стека к операндам на вершине стека операндов
+	auto reduce = [&]() {
+		const Lexeme& op = *operators.back();
+		operators.pop_back();
+		if (op.type == Lexeme::Type::negative) {
+			AlgExpression* p = make_node(Type::negative, op);
+			p->term_l = operands.back();
+			operands.back() = p;
+			return true;
 		}
-	}
-	return nullptr;
-}
-
-AlgExpression* AlgExpression::scan_star(const vector<AlgExpression::Lexeme>& lexemes,
-										int index_start, int index_end) {
-	AlgExpression* p = nullptr;
-	int balance = 0;
-	for (int i = index_start; i < index_end; i++) {
-		update_balance(lexemes[i], balance);
-		if (lexemes[i].type == Lexeme::Type::star && balance == 0) {
-			AlgExpression* l = expr(lexemes, index_start, i);
-			if (l == nullptr || l->type == AlgExpression::eps) {
-				delete l;
-				return p;
-			}
 
-			p = make();
-			p->term_l = l;
-			p->type = Type::star;
-
-			p->alphabet = l->alphabet;
-			return p;
+		AlgExpression* l = operands[operands.size() - 2];
+		AlgExpression* r = operands.back();
+		if (op.type == Lexeme::Type::conc && (l->type == Type::eps || r->type == Type::eps))
+			return false;
+		AlgExpression* p = make_node(op.type == Lexeme::Type::alt ? Type::alt : Type::conc, op);
+		p->term_l = l;
+		p->term_r = r;
+		operands.pop_back();
+		operands.back() = p;
+		return true;
+	};
+
+	// лексемы проверяются одним проходом: операнд ожидается в начале,
+	// после открывающей скобки, '^' и бинарных операторов
+	bool operand_expected = true;
+	for (const Lexeme& lexeme : lexemes) {
+		switch (lexeme.type) {
+		case Lexeme::Type::symb:
+		case Lexeme::Type::eps:
+		case Lexeme::Type::ref: {
+			if (!operand_expected)
+				return fail(lexeme.position);
+			Type node_type = Type::symb;
+			if (lexeme.type == Lexeme::Type::eps)
+				node_type = Type::eps;
+			else if (lexeme.type == Lexeme::Type::ref)
+				node_type = Type::ref;
+			operands.push_back(make_node(node_type, lexeme));
+			operand_expected = false;
+			break;
 		}
-	}
-	return nullptr;
-}
-
-AlgExpression* AlgExpression::scan_alt(const vector<AlgExpression::Lexeme>& lexemes,
-									   int index_start, int index_end) {
-	AlgExpression* p = nullptr;
-	int balance = 0;
-	for (int i = index_start; i < index_end; i++) {
-		update_balance(lexemes[i], balance);
-		if (lexemes[i].type == Lexeme::Type::alt && balance == 0) {
-			AlgExpression* l = expr(lexemes, index_start, i);
-			AlgExpression* r = expr(lexemes, i + 1, index_end);
-			if (l == nullptr || r == nullptr) { // Проверка на адекватность)
-				delete r;
-				delete l;
-				return nullptr;
+		case Lexeme::Type::parL:
+		case Lexeme::Type::squareBrL:
+		case Lexeme::Type::negative:
+			if (!operand_expected)
+				return fail(lexeme.position);
+			operators.push_back(&lexeme);
+			break;
+		case Lexeme::Type::alt:
+		case Lexeme::Type::conc:
+			if (operand_expected)
+				return fail(lexeme.position);
+			// '|' и '.' правоассоциативны, поэтому сворачиваются только более сильные операторы
+			while (!operators.empty() &&
+				   priority(operators.back()->type) > priority(lexeme.type))
+				if (!reduce())
+					return fail(lexeme.position);
+			operators.push_back(&lexeme);
+			operand_expected = true;
+			break;
+		case Lexeme::Type::star: {
+			if (operand_expected)
+				return fail(lexeme.position);
+			// '^' связывает сильнее итерации: ^a* = (^a)*
+			while (!operators.empty() && operators.back()->type == Lexeme::Type::negative)
+				reduce();
+			if (operands.back()->type == Type::eps)
+				return fail(lexeme.position);
+			AlgExpression* p = make_node(Type::star, lexeme);
+			p->term_l = operands.back();
+			operands.back() = p;
+			break;
+		}
+		case Lexeme::Type::parR:
+		case Lexeme::Type::squareBrR: {
+			if (operand_expected)
+				return fail(lexeme.position);
+			while (!operators.empty() && priority(operators.back()->type) > 0)
+				if (!reduce())
+					return fail(lexeme.position);
+			Lexeme::Type opening = lexeme.type == Lexeme::Type::parR ? Lexeme::Type::parL
+																	 : Lexeme::Type::squareBrL;
+			if (operators.empty() || operators.back()->type != opening)
+				return fail(lexeme.position);
+			const Lexeme& bracket = *operators.back();
+			operators.pop_back();
+			if (opening == Lexeme::Type::squareBrL) {
+				if (operands.back()->type == Type::eps)
+					return fail(lexeme.position);
+				AlgExpression* p = make_node(Type::memoryWriter, bracket);
+				p->term_l = operands.back();
+				operands.back() = p;
 			}
-
-			p = make();
-			p->term_l = l;
-			p->term_r = r;
-			p->type = Type::alt;
-
-			p->alphabet = l->alphabet;
-			p->alphabet.insert(r->alphabet.begin(), r->alphabet.end());
-			return p;
+			break;
+		}
+		default:
+			return fail(lexeme.position);
 		}
 	}
-	return nullptr;
-}
-
-AlgExpression* AlgExpression::scan_symb(const vector<AlgExpression::Lexeme>& lexemes,
-										int index_start, int index_end) {
-	AlgExpression* p = nullptr;
-	if (index_start >= lexemes.size() || (index_end - index_start > 1) ||
-		lexemes[index_start].type != Lexeme::Type::symb) {
-		return nullptr;
-	}
-
-	p = make();
-	p->symbol = lexemes[index_start].symbol;
-	p->type = AlgExpression::symb;
-	p->alphabet = {lexemes[index_start].symbol};
-	return p;
-}
-
-AlgExpression* AlgExpression::scan_eps(const vector<AlgExpression::Lexeme>& lexemes,
-									   int index_start, int index_end) {
-	AlgExpression* p = nullptr;
-	if (index_start >= lexemes.size() || (index_end - index_start != 1) ||
-		lexemes[index_start].type != Lexeme::Type::eps) {
-		return nullptr;
-	}
-
-	p = make();
-	p->symbol = Symbol::Epsilon;
-	p->type = AlgExpression::eps;
-	return p;
-}
 
-AlgExpression* AlgExpression::scan_par(const vector<AlgExpression::Lexeme>& lexemes,
-									   int index_start, int index_end) {
-	AlgExpression* p = nullptr;
-	if ((index_end - 1) >= lexemes.size() || (lexemes[index_start].type != Lexeme::Type::parL ||
-											  lexemes[index_end - 1].type != Lexeme::Type::parR)) {
-		return nullptr;
+	size_t end_position = lexemes.empty() ? 0 : lexemes.back().position;
+	if (operand_expected)
+		return fail(end_position);
+	while (!operators.empty()) {
+		if (priority(operators.back()->type) == 0)
+			return fail(operators.back()->position);
+		if (!reduce())
+			return fail(end_position);
 	}
-
-	p = expr(lexemes, index_start + 1, index_end - 1);
-	return p;
+	return operands.back();
 }
 
 bool AlgExpression::equality_checker(const AlgExpression* expr1, const AlgExpression* expr2) {
@@ -13,9 +13,11 @@ using std::vector;
 
 BackRefRegex::BackRefRegex(const string& str) : BackRefRegex() {
 	try {
-		bool res = from_string(str, true, false);
+		size_t error_position;
+		bool res = from_string(str, error_position, true, false);
 		if (!res) {
-			throw std::runtime_error("BackRefRegex::from_string() ERROR");
+			throw std::runtime_error("BackRefRegex::from_string() ERROR: invalid regex \"" +
+									 str + "\" at position " + to_string(error_position));
 		}
 	} catch (const std::runtime_error& re) {
 		cerr << re.what() << "\n";
@@ -28,8 +30,13 @@ BackRefRegex::BackRefRegex(const BackRefRegex& other) : AlgExpression(other) {
 	lin_number = other.lin_number;
 }
 
+// как и при копировании, ref_to и may_be_eps корня не переносятся
+BackRefRegex::BackRefRegex(BackRefRegex&& other) noexcept : AlgExpression(std::move(other)) {
+	cell_number = other.cell_number;
+	lin_number = other.lin_number;
+}
+
 BackRefRegex::BackRefRegex(const Regex* regex, const Alphabet& _alphabet) : BackRefRegex(regex) {
-	alphabet = _alphabet;
 	language = std::make_shared<Language>(_alphabet);
 }
 
@@ -51,9 +58,23 @@ BackRefRegex& BackRefRegex::operator=(const BackRefRegex& other) {
 	return *this;
 }
 
+BackRefRegex& BackRefRegex::operator=(BackRefRegex&& other) noexcept {
+	if (this != &other) {
+		clear();
+		move_from(other);
+	}
+	return *this;
+}
+
+void BackRefRegex::move_from(AlgExpression& other) noexcept {
+	AlgExpression::move_from(other);
+	auto& tmp = static_cast<BackRefRegex&>(other);
+	cell_number = tmp.cell_number;
+	lin_number = tmp.lin_number;
+}
+
 void BackRefRegex::copy(const AlgExpression* other) {
 	auto* tmp = cast(other);
-	alphabet = tmp->alphabet;
 	type = tmp->type;
 	symbol = tmp->symbol;
 	language = tmp->language;
@@ -176,69 +197,10 @@ string BackRefRegex::type_to_str() const {
 	return {};
 }
 
-BackRefRegex* BackRefRegex::expr(const vector<AlgExpression::Lexeme>& lexemes, int index_start,
-								 int index_end) {
-	AlgExpression* p;
-	p = scan_alt(lexemes, index_start, index_end);
-	if (!p) {
-		p = scan_conc(lexemes, index_start, index_end);
-	}
-	if (!p) {
-		p = scan_star(lexemes, index_start, index_end);
-	}
-	if (!p) {
-		p = scan_symb(lexemes, index_start, index_end);
-	}
-	if (!p) {
-		p = scan_ref(lexemes, index_start, index_end);
-	}
-	if (!p) {
-		p = scan_eps(lexemes, index_start, index_end);
-	}
-	if (!p) {
-		p = scan_par(lexemes, index_start, index_end);
-	}
-	if (!p) {
-		p = scan_square_br(lexemes, index_start, index_end);
-	}
-	return cast(p, false);
-}
-
-BackRefRegex* BackRefRegex::scan_ref(const vector<AlgExpression::Lexeme>& lexemes, int index_start,
-									 int index_end) {
-	BackRefRegex* p = nullptr;
-	if (index_start >= lexemes.size() || (index_end - index_start > 1) ||
-		lexemes[index_start].type != Lexeme::Type::ref) {
-		return nullptr;
-	}
-
-	p = new BackRefRegex();
-	p->symbol = lexemes[index_start].symbol;
-	p->type = AlgExpression::ref;
-	p->cell_number = lexemes[index_start].number;
-	return p;
-}
-
-BackRefRegex* BackRefRegex::scan_square_br(const vector<AlgExpression::Lexeme>& lexemes,
-										   int index_start, int index_end) {
-	BackRefRegex* p = nullptr;
-	if ((index_end - 1) >= lexemes.size() ||
-		(lexemes[index_start].type != Lexeme::Type::squareBrL ||
-		 lexemes[index_end - 1].type != Lexeme::Type::squareBrR)) {
-		return nullptr;
-	}
-
-	BackRefRegex* l = expr(lexemes, index_start + 1, index_end - 1);
-	if (l == nullptr || l->type == AlgExpression::eps) {
-		delete l;
-		return p;
-	}
-
-	p = new BackRefRegex();
-	p->term_l = l;
-	p->type = AlgExpression::memoryWriter;
-	p->cell_number = lexemes[index_start].number;
-	p->alphabet = l->alphabet;
+BackRefRegex* BackRefRegex::make_node(Type node_type, const Lexeme& lexeme) const {
+	BackRefRegex* p = cast(AlgExpression::make_node(node_type, lexeme));
+	if (node_type == Type::ref || node_type == Type::memoryWriter)
+		p->cell_number = lexeme.number;
 	return p;
 }
 
@@ -422,7 +384,7 @@ MemoryFiniteAutomaton BackRefRegex::to_mfa(iLogTemplate* log) const {
 		states[i].index = i;
 		states[i].identifier = to_string(i);
 	}
-	MemoryFiniteAutomaton mfa(0, states, language);
+	MemoryFiniteAutomaton mfa(0, states, get_or_make_language());
 	if (log) {
 		log->set_parameter("brefregex", *this);
 		log->set_parameter("result", mfa);
@@ -827,7 +789,7 @@ MemoryFiniteAutomaton BackRefRegex::to_mfa_additional(iLogTemplate* log) const {
 			i + 1, symb, last_terms.count(symb.last_linearization_number()), transitions);
 	}
 
-	MemoryFiniteAutomaton mfa(0, states, language);
+	MemoryFiniteAutomaton mfa(0, states, get_or_make_language());
 	if (log) {
 		log->set_parameter("brefregex", *this);
 		log->set_parameter("result", mfa);
@@ -964,7 +926,6 @@ void BackRefRegex::swap_memory_operations(unordered_set<BackRefRegex*>& already_
 	case ref:
 		if (ref_to && !already_swapped.count(ref_to)) {
 			already_swapped.insert(ref_to);
-			swap(alphabet, ref_to->alphabet);
 			swap(type, ref_to->type);
 			swap(symbol, ref_to->symbol);
 			swap(language, ref_to->language);
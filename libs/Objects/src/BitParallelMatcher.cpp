@@ -0,0 +1,130 @@
+#include <algorithm>
+
+#include "Objects/BitParallelMatcher.h"
+#include "Objects/FiniteAutomaton.h"
+#include "Objects/Regex.h"
+
+using std::pair;
+using std::string;
+using std::string_view;
+using std::vector;
+
+BitParallelMatcher::BitParallelMatcher(const Regex& regex) {
+	// автомат Глушкова однороден: все переходы в позицию помечены её символом
+	FiniteAutomaton glushkov = regex.to_glushkov();
+	FATransitionTable table = glushkov.get_transition_table();
+	positions_number = glushkov.size();
+	words_number = (positions_number + 63) / 64;
+	chunks_number = (positions_number + 7) / 8;
+
+	symbol_masks.assign(256 * words_number, 0);
+	vector<uint64_t> follow(positions_number * words_number, 0);
+	final_mask.assign(words_number, 0);
+	auto set_bit = [](uint64_t* mask, int bit) { mask[bit / 64] |= uint64_t(1) << (bit % 64); };
+	for (int c = 0; c < 256; c++) {
+		auto symbol = table.find_symbol(static_cast<char>(c));
+		if (!symbol)
+			continue;
+		for (int from = 0; from < positions_number; from++)
+			for (int to : table.get_transitions(from, *symbol))
+				set_bit(&symbol_masks[c * words_number], to);
+	}
+	for (int from = 0; from < positions_number; from++) {
+		for (int symbol = 0; symbol < table.symbols_count(); symbol++)
+			for (int to : table.get_transitions(from, symbol))
+				set_bit(&follow[from * words_number], to);
+		if (glushkov.states[from].is_terminal)
+			set_bit(final_mask.data(), from);
+	}
+
+	// значение байта value получает объединение строки для value без младшего бита
+	// и follow-множества позиции этого бита
+	follow_table.assign(chunks_number * 256 * words_number, 0);
+	for (int chunk = 0; chunk < chunks_number; chunk++)
+		for (int value = 1; value < 256; value++) {
+			int low_bit = 0;
+			while (!((value >> low_bit) & 1))
+				low_bit++;
+			int position = chunk * 8 + low_bit;
+			uint64_t* row = &follow_table[(chunk * 256 + value) * words_number];
+			const uint64_t* previous =
+				&follow_table[(chunk * 256 + (value & (value - 1))) * words_number];
+			for (int w = 0; w < words_number; w++)
+				row[w] = previous[w] |
+						 (position < positions_number ? follow[position * words_number + w] : 0);
+		}
+}
+
+size_t BitParallelMatcher::positions_count() const {
+	return positions_number;
+}
+
+size_t BitParallelMatcher::words_count() const {
+	return words_number;
+}
+
+bool BitParallelMatcher::match_single_word(string_view word) const {
+	uint64_t active = 1;
+	for (unsigned char c : word) {
+		uint64_t next = 0;
+		for (int chunk = 0; chunk < chunks_number; chunk++)
+			next |= follow_table[chunk * 256 + ((active >> (chunk * 8)) & 255)];
+		active = next & symbol_masks[c];
+		if (!active)
+			return false;
+	}
+	return active & final_mask[0];
+}
+
+bool BitParallelMatcher::match_multi_word(string_view word, uint64_t* buffer) const {
+	uint64_t* active = buffer;
+	uint64_t* next = buffer + words_number;
+	std::fill(active, active + words_number, 0);
+	active[0] = 1;
+	for (unsigned char c : word) {
+		std::fill(next, next + words_number, 0);
+		for (int chunk = 0; chunk < chunks_number; chunk++) {
+			int value = (active[chunk / 8] >> (chunk % 8 * 8)) & 255;
+			if (!value)
+				continue;
+			const uint64_t* row = &follow_table[(chunk * 256 + value) * words_number];
+			for (int w = 0; w < words_number; w++)
+				next[w] |= row[w];
+		}
+		const uint64_t* mask = &symbol_masks[c * words_number];
+		uint64_t any = 0;
+		for (int w = 0; w < words_number; w++) {
+			next[w] &= mask[w];
+			any |= next[w];
+		}
+		if (!any)
+			return false;
+		std::swap(active, next);
+	}
+	for (int w = 0; w < words_number; w++)
+		if (active[w] & final_mask[w])
+			return true;
+	return false;
+}
+
+bool BitParallelMatcher::match(string_view word) const {
+	if (words_number == 1)
+		return match_single_word(word);
+	if (words_number <= max_stack_words) {
+		uint64_t buffer[2 * max_stack_words];
+		return match_multi_word(word, buffer);
+	}
+	vector<uint64_t> buffer(2 * words_number);
+	return match_multi_word(word, buffer.data());
+}
+
+vector<bool> BitParallelMatcher::match(const vector<string_view>& words) const {
+	vector<bool> result(words.size());
+	for (int i = 0; i < words.size(); i++)
+		result[i] = match(words[i]);
+	return result;
+}
+
+pair<int, bool> BitParallelMatcher::parse(const string& word) const {
+	return {word.size() * words_number, match(word)};
+}
@@ -0,0 +1,130 @@
+#include <map>
+#include <utility>
+
+#include "Objects/DFAMatcher.h"
+#include "Objects/FiniteAutomaton.h"
+
+using std::string_view;
+using std::vector;
+
+DFAMatcher::DFAMatcher(const FiniteAutomaton& fa) {
+	const FiniteAutomaton dfa = fa.is_deterministic() ? fa : fa.determinize();
+	FATransitionTable transitions = dfa.get_transition_table();
+	// последнее состояние - ловушка, в неё ведут отсутствующие переходы и переходы
+	// в состояния, из которых финальные недостижимы (в том числе ловушки самого автомата)
+	states_number = dfa.states.size() + 1;
+	uint32_t trap = dfa.states.size();
+	vector<bool> is_terminal;
+	for (const FAState& state : dfa.states)
+		is_terminal.push_back(state.is_terminal);
+	vector<bool> productive = transitions.get_productive(is_terminal);
+
+	// столбец переходов байта по всем состояниям определяет его класс; байты, не
+	// соответствующие символам, всегда ведут в ловушку и попадают в один класс
+	vector<vector<uint32_t>> columns;
+	std::map<vector<uint32_t>, uint32_t> class_by_column;
+	auto add_column = [&](vector<uint32_t>& column) {
+		auto [it, inserted] = class_by_column.emplace(column, columns.size());
+		if (inserted)
+			columns.push_back(std::move(column));
+		return it->second;
+	};
+	vector<uint32_t> trap_column(states_number, trap);
+	uint32_t trap_class = add_column(trap_column);
+	for (int c = 0; c < 256; c++) {
+		auto symbol = transitions.find_symbol(static_cast<char>(c));
+		if (!symbol) {
+			byte_class[c] = trap_class;
+			continue;
+		}
+		vector<uint32_t> column(states_number, trap);
+		for (int state = 0; state < dfa.states.size(); state++) {
+			auto targets = transitions.get_transitions(state, *symbol);
+			if (!targets.empty() && productive[*targets.begin()])
+				column[state] = *targets.begin();
+		}
+		byte_class[c] = add_column(column);
+	}
+	classes_number = columns.size();
+
+	table.resize(states_number * classes_number);
+	for (uint32_t state = 0; state < states_number; state++)
+		for (uint32_t cls = 0; cls < classes_number; cls++)
+			table[state * classes_number + cls] = columns[cls][state] * classes_number;
+
+	accepting.assign((states_number + 63) / 64, 0);
+	for (int state = 0; state < dfa.states.size(); state++)
+		if (dfa.states[state].is_terminal)
+			accepting[state / 64] |= uint64_t(1) << (state % 64);
+	initial_offset = (productive[dfa.initial_state] ? dfa.initial_state : trap) * classes_number;
+	trap_offset = trap * classes_number;
+}
+
+size_t DFAMatcher::states_count() const {
+	return states_number;
+}
+
+size_t DFAMatcher::byte_classes_count() const {
+	return classes_number;
+}
+
+bool DFAMatcher::is_accepting(uint32_t offset) const {
+	uint32_t state = offset / classes_number;
+	return (accepting[state / 64] >> (state % 64)) & 1;
+}
+
+size_t DFAMatcher::run(string_view word) const {
+	const uint32_t* transitions = table.data();
+	uint32_t offset = initial_offset;
+	for (unsigned char c : word) {
+		offset = transitions[offset + byte_class[c]];
+		if (offset == trap_offset)
+			break;
+	}
+	return offset / classes_number;
+}
+
+bool DFAMatcher::match(string_view word) const {
+	return is_accepting(run(word) * classes_number);
+}
+
+vector<bool> DFAMatcher::match(const vector<string_view>& words) const {
+	vector<bool> result(words.size());
+	for (int i = 0; i < words.size(); i++)
+		result[i] = match(words[i]);
+	return result;
+}
+
+size_t DFAMatcher::count_matches(const vector<string_view>& words) const {
+	size_t result = 0;
+	for (string_view word : words)
+		result += match(word);
+	return result;
+}
+
+DFAMatcher::Stream::Stream(const DFAMatcher& matcher)
+	: matcher(matcher), offset(matcher.initial_offset) {}
+
+void DFAMatcher::Stream::reset() {
+	offset = matcher.initial_offset;
+	consumed = 0;
+}
+
+bool DFAMatcher::Stream::feed(string_view chunk) {
+	if (offset == matcher.trap_offset)
+		return false;
+	const uint32_t* transitions = matcher.table.data();
+	for (size_t i = 0; i < chunk.size(); i++) {
+		offset = transitions[offset + matcher.byte_class[static_cast<unsigned char>(chunk[i])]];
+		if (offset == matcher.trap_offset) {
+			consumed += i + 1;
+			return false;
+		}
+	}
+	consumed += chunk.size();
+	return true;
+}
+
+bool DFAMatcher::Stream::finish() const {
+	return matcher.is_accepting(offset);
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <stack>
+
+#include "Objects/FATransitionTable.h"
+#include "Objects/FiniteAutomaton.h"
+
+using std::optional;
+using std::string;
+using std::vector;
+
+FATransitionTable::Targets::Targets(const Index* first, const Index* last)
+	: first(first), last(last) {}
+
+const FATransitionTable::Index* FATransitionTable::Targets::begin() const {
+	return first;
+}
+
+const FATransitionTable::Index* FATransitionTable::Targets::end() const {
+	return last;
+}
+
+size_t FATransitionTable::Targets::size() const {
+	return last - first;
+}
+
+bool FATransitionTable::Targets::empty() const {
+	return first == last;
+}
+
+FATransitionTable::FATransitionTable(const vector<FAState>& states, const Alphabet& alphabet)
+	: states_number(states.size()) {
+	auto intern = [&](const Symbol& symb) {
+		auto [it, is_new] = symbol_index.emplace(symb, symbols.size());
+		if (is_new) {
+			symbols.push_back(symb);
+			string value = symb;
+			if (value.size() == 1 && !symb.is_annotated() && !symb.is_linearized() &&
+				!symb.is_ref())
+				char_index[static_cast<unsigned char>(value[0])] = it->second;
+		}
+		return it->second;
+	};
+	for (const Symbol& symb : alphabet)
+		intern(symb);
+	alphabet_symbols_count = symbols.size();
+	for (const auto& state : states)
+		for (const auto& [symb, states_to] : state.transitions)
+			intern(symb);
+	epsilon = find_symbol(Symbol(Symbol::Epsilon));
+
+	size_t k = symbols.size();
+	offsets.assign(states.size() * k + 1, 0);
+	for (const auto& state : states)
+		for (const auto& [symb, states_to] : state.transitions)
+			offsets[state.index * k + symbol_index.at(symb) + 1] = states_to.size();
+	for (size_t i = 1; i < offsets.size(); i++)
+		offsets[i] += offsets[i - 1];
+	targets.resize(offsets.back());
+	for (const auto& state : states)
+		for (const auto& [symb, states_to] : state.transitions)
+			// std::set уже упорядочен, поэтому цели на отрезке отсортированы
+			std::copy(states_to.begin(),
+					  states_to.end(),
+					  targets.begin() + offsets[state.index * k + symbol_index.at(symb)]);
+}
+
+size_t FATransitionTable::states_count() const {
+	return states_number;
+}
+
+size_t FATransitionTable::symbols_count() const {
+	return symbols.size();
+}
+
+size_t FATransitionTable::alphabet_size() const {
+	return alphabet_symbols_count;
+}
+
+size_t FATransitionTable::transitions_count() const {
+	return targets.size();
+}
+
+const Symbol& FATransitionTable::get_symbol(Index symbol) const {
+	return symbols[symbol];
+}
+
+optional<FATransitionTable::Index> FATransitionTable::find_symbol(const Symbol& symb) const {
+	auto it = symbol_index.find(symb);
+	if (it == symbol_index.end())
+		return std::nullopt;
+	return it->second;
+}
+
+optional<FATransitionTable::Index> FATransitionTable::find_symbol(char c) const {
+	return char_index[static_cast<unsigned char>(c)];
+}
+
+optional<FATransitionTable::Index> FATransitionTable::get_epsilon() const {
+	return epsilon;
+}
+
+FATransitionTable::Targets FATransitionTable::get_transitions(int state, Index symbol) const {
+	size_t i = state * symbols.size() + symbol;
+	return {targets.data() + offsets[i], targets.data() + offsets[i + 1]};
+}
+
+vector<bool> FATransitionTable::get_productive(const vector<bool>& is_terminal) const {
+	// обратный обход от финальных состояний
+	vector<vector<int>> predecessors(states_number);
+	for (size_t from = 0; from < states_number; from++)
+		for (Index symbol = 0; symbol < symbols.size(); symbol++)
+			for (int to : get_transitions(from, symbol))
+				predecessors[to].push_back(from);
+
+	vector<bool> productive(is_terminal);
+	std::stack<int> s;
+	for (size_t state = 0; state < states_number; state++)
+		if (productive[state])
+			s.push(state);
+	while (!s.empty()) {
+		int to = s.top();
+		s.pop();
+		for (int from : predecessors[to])
+			if (!productive[from]) {
+				productive[from] = true;
+				s.push(from);
+			}
+	}
+	return productive;
+}
+
+FAEpsClosures::FAEpsClosures(const FATransitionTable& table)
+	: table(table), closures(table.states_count()), is_closure_ready(table.states_count()),
+	  closure_stamp(table.states_count(), -1), subset_stamp(table.states_count(), -1) {}
+
+const vector<int>& FAEpsClosures::get_closure(int state) {
+	if (!is_closure_ready[state]) {
+		vector<int>& reachable = closures[state];
+		std::stack<int> s;
+		s.push(state);
+		closure_stamp[state] = state;
+		while (!s.empty()) {
+			int from = s.top();
+			s.pop();
+			reachable.push_back(from);
+			if (!table.get_epsilon())
+				continue;
+			for (int to : table.get_transitions(from, *table.get_epsilon()))
+				if (closure_stamp[to] != state) {
+					closure_stamp[to] = state;
+					s.push(to);
+				}
+		}
+		is_closure_ready[state] = true;
+	}
+	return closures[state];
+}
+
+vector<int> FAEpsClosures::get_closure(const vector<int>& states) {
+	vector<int> subset;
+	subset_counter++;
+	for (int state : states)
+		for (int reachable : get_closure(state))
+			if (subset_stamp[reachable] != subset_counter) {
+				subset_stamp[reachable] = subset_counter;
+				subset.push_back(reachable);
+			}
+	std::sort(subset.begin(), subset.end());
+	return subset;
+}
+
+std::size_t FASubsetHasher::operator()(const vector<int>& subset) const {
+	std::size_t seed = subset.size();
+	for (int i : subset) {
+		seed ^= std::hash<int>()(i) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+	return seed;
+}
+
+std::size_t FASubsetHasher::operator()(const vector<uint64_t>& subset) const {
+	std::size_t seed = subset.size();
+	// слова битового множества перемешиваются: сами по себе они плохо
+	// распределяются по корзинам
+	for (uint64_t i : subset) {
+		i *= 0x9e3779b97f4a7c15;
+		seed ^= (i ^ (i >> 32)) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+	return seed;
+}
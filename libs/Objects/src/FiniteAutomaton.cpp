@@ -4,6 +4,7 @@
 #include <set>
 #include <sstream>
 #include <stack>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -15,6 +16,9 @@
 #include "Objects/Language.h"
 #include "Objects/MemoryFiniteAutomaton.h"
 #include "Objects/MetaInfo.h"
+#include "Objects/PathCounter.h"
+#include "Objects/RegexDAG.h"
+#include "Objects/RegexDerivatives.h"
 #include "Objects/iLogTemplate.h"
 
 using std::cerr;
@@ -119,6 +123,13 @@ vector<FAState> FiniteAutomaton::get_states() const {
 	return states;
 }
 
+FATransitionTable FiniteAutomaton::get_transition_table() const {
+	// без языка символы таблицы берутся только из переходов состояний
+	if (!language)
+		return {states, Alphabet()};
+	return {states, language->get_alphabet()};
+}
+
 // обход автомата в глубину
 void FiniteAutomaton::dfs(int index,
 						  set<int>& reachable, // NOLINT(runtime/references)
@@ -151,39 +162,48 @@ FiniteAutomaton FiniteAutomaton::determinize(bool is_trim, iLogTemplate* log) co
 	if (!is_trim)
 		if (log)
 			log->set_parameter("trap", " (с добавлением ловушки)");
+
+	// подмножества состояний НКА хранятся отсортированными векторами
+	FATransitionTable table = get_transition_table();
+	FAEpsClosures eps_closures(table);
+	auto get_identifier = [&](const vector<int>& subset) {
+		string identifier;
+		for (int elem : subset) {
+			identifier += (identifier.empty() || states[elem].identifier.empty() ? "" : ", ") +
+						  states[elem].identifier;
+		}
+		return identifier;
+	};
+
 	FiniteAutomaton dfa = FiniteAutomaton(0, {}, language);
-	set<int> q0 = closure({initial_state}, true);
 	MetaInfo old_meta, new_meta;
-	set<int> label = q0;
-	string new_identifier;
 	int group_counter = 0;
-	for (auto elem : label) {
-		new_identifier += (new_identifier.empty() || states[elem].identifier.empty() ? "" : ", ") +
-						  states[elem].identifier;
-	}
-	FAState new_initial_state = {0, label, new_identifier, false, FAState::Transitions()};
-	dfa.states.push_back(new_initial_state);
-
-	if (q0.size() > 1) {
-		for (auto elem : q0) {
+	// номер состояния ДКА по подмножеству; ключи таблицы не перемещаются,
+	// поэтому по номеру состояния хранится указатель на его подмножество
+	std::unordered_map<vector<int>, int, FASubsetHasher> index_by_subset;
+	vector<const vector<int>*> subset_by_index;
+
+	vector<int> q0 = eps_closures.get_closure(vector<int>{initial_state});
+	dfa.states.emplace_back(
+		0, set<int>(q0.begin(), q0.end()), get_identifier(q0), false, FAState::Transitions());
+	if (log && q0.size() > 1) {
+		set<int> label(q0.begin(), q0.end());
+		for (auto elem : label) {
 			old_meta.upd(NodeMeta{states[elem].index, group_counter});
 		}
-		old_meta.mark_transitions(*this, q0, q0, Symbol::Epsilon, group_counter);
-		new_meta.upd(NodeMeta{new_initial_state.index, group_counter});
+		old_meta.mark_transitions(*this, label, label, Symbol::Epsilon, group_counter);
+		new_meta.upd(NodeMeta{0, group_counter});
 		group_counter++;
 	}
+	subset_by_index.push_back(&index_by_subset.emplace(std::move(q0), 0).first->first);
 
-	std::stack<set<int>> s1;
-	std::stack<int> s2;
-	s1.push(q0);
-	s2.push(0);
-
-	while (!s1.empty()) {
-		set<int> z = s1.top();
-		int index = s2.top();
-		s1.pop();
-		s2.pop();
-		FAState q = dfa.states[index];
+	stack<int> s;
+	s.push(0);
+	vector<int> new_x;
+	while (!s.empty()) {
+		int index = s.top();
+		s.pop();
+		const vector<int>& z = *subset_by_index[index];
 
 		for (int i : z) {
 			if (states[i].is_terminal) {
@@ -192,56 +212,40 @@ FiniteAutomaton FiniteAutomaton::determinize(bool is_trim, iLogTemplate* log) co
 			}
 		}
 
-		set<int> new_x;
-		for (const Symbol& symb : language->get_alphabet()) {
+		for (FATransitionTable::Index symbol = 0; symbol < table.alphabet_size(); symbol++) {
+			const Symbol& symb = table.get_symbol(symbol);
 			new_x.clear();
 			for (int j : z) {
-				auto transitions_by_symbol = states[j].transitions.find(symb);
-				if (transitions_by_symbol != states[j].transitions.end())
-					for (int k : transitions_by_symbol->second) {
-						new_x.insert(k);
-					}
-			}
-
-			set<int> z1 = closure(new_x, true);
-			new_identifier = "";
-			for (auto elem : z1) {
-				new_identifier +=
-					(new_identifier.empty() || states[elem].identifier.empty() ? "" : ", ") +
-					states[elem].identifier;
-			}
-
-			FAState q1 = {-1, z1, new_identifier, false, FAState::Transitions()};
-			bool accessory_flag = false;
-
-			for (const auto& state : dfa.states) {
-				if (q1.label == state.label) {
-					index = state.index;
-					accessory_flag = true;
-					break;
-				}
-			}
-
-			if (!accessory_flag)
-				index = -1;
-			if (index != -1) {
-				q1 = dfa.states[index];
-			} else {
-				index = dfa.size();
-				q1.index = index;
-				dfa.states.push_back(q1);
-				s1.push(z1);
-				s2.push(index);
-				if (z1.size() > 1) {
+				auto transitions_by_symbol = table.get_transitions(j, symbol);
+				new_x.insert(
+					new_x.end(), transitions_by_symbol.begin(), transitions_by_symbol.end());
+			}
+
+			auto [it, is_new] =
+				index_by_subset.emplace(eps_closures.get_closure(new_x), int(dfa.states.size()));
+			const vector<int>& z1 = it->first;
+			if (is_new) {
+				dfa.states.emplace_back(it->second,
+										set<int>(z1.begin(), z1.end()),
+										get_identifier(z1),
+										false,
+										FAState::Transitions());
+				subset_by_index.push_back(&z1);
+				s.push(it->second);
+				if (log && z1.size() > 1) {
 					for (auto elem : z1) {
 						old_meta.upd(NodeMeta{states[elem].index, group_counter});
 					}
-					old_meta.mark_transitions(*this, z, z1, symb, group_counter);
-					new_meta.upd(NodeMeta{q1.index, group_counter});
+					old_meta.mark_transitions(*this,
+											  set<int>(z.begin(), z.end()),
+											  set<int>(z1.begin(), z1.end()),
+											  symb,
+											  group_counter);
+					new_meta.upd(NodeMeta{it->second, group_counter});
 					group_counter++;
 				}
 			}
-			dfa.states[q.index].transitions[symb].insert(q1.index);
+			dfa.states[index].transitions[symb].insert(it->second);
 		}
 	}
 	if (log) {
@@ -259,6 +263,370 @@ FiniteAutomaton FiniteAutomaton::determinize(bool is_trim, iLogTemplate* log) co
 	return dfa;
 }
 
+vector<int> FiniteAutomaton::get_hopcroft_classes() const {
+	// отсутствующие переходы ведут в неявную ловушку с индексом n,
+	// поэтому на вход можно подавать и неполный ДКА
+	FATransitionTable table = get_transition_table();
+	int n = states.size();
+	int k = table.alphabet_size();
+	int total = n + 1;
+
+	// обратная функция переходов: прообразы пары (состояние, символ) хранятся подряд
+	vector<int> delta(total * k, n);
+	for (int i = 0; i < n; i++)
+		for (int a = 0; a < k; a++) {
+			auto transitions_by_symbol = table.get_transitions(i, a);
+			if (!transitions_by_symbol.empty())
+				delta[i * k + a] = *transitions_by_symbol.begin();
+		}
+	vector<int> preimage_begin(total * k + 1, 0);
+	for (int i = 0; i < total; i++)
+		for (int a = 0; a < k; a++)
+			preimage_begin[delta[i * k + a] * k + a + 1]++;
+	for (int i = 1; i < preimage_begin.size(); i++)
+		preimage_begin[i] += preimage_begin[i - 1];
+	vector<int> preimages(total * k);
+	vector<int> filled(preimage_begin.begin(), preimage_begin.end() - 1);
+	for (int i = 0; i < total; i++)
+		for (int a = 0; a < k; a++)
+			preimages[filled[delta[i * k + a] * k + a]++] = i;
+
+	// разбиение: элементы каждого блока занимают непрерывный отрезок массива elements,
+	// помеченные при очередном расщеплении элементы переносятся в начало отрезка
+	vector<int> elements, position(total), block_of(total);
+	vector<int> block_begin, block_end, block_marked;
+	for (int i = 0; i < n; i++)
+		if (states[i].is_terminal)
+			elements.push_back(i);
+	int terminals_count = elements.size();
+	for (int i = 0; i < total; i++)
+		if (i == n || !states[i].is_terminal)
+			elements.push_back(i);
+	if (terminals_count) {
+		block_begin.push_back(0);
+		block_end.push_back(terminals_count);
+		block_marked.push_back(0);
+	}
+	block_begin.push_back(terminals_count);
+	block_end.push_back(total);
+	block_marked.push_back(0);
+	for (int b = 0; b < block_begin.size(); b++)
+		for (int p = block_begin[b]; p < block_end[b]; p++) {
+			position[elements[p]] = p;
+			block_of[elements[p]] = b;
+		}
+
+	auto block_size = [&](int b) { return block_end[b] - block_begin[b]; };
+	vector<pair<int, int>> splitters;
+	vector<bool> is_splitter(block_begin.size() * k);
+	auto add_splitter = [&](int b, int a) {
+		splitters.emplace_back(b, a);
+		is_splitter[b * k + a] = true;
+	};
+	if (block_begin.size() == 2) {
+		int smaller = block_size(0) <= block_size(1) ? 0 : 1;
+		for (int a = 0; a < k; a++)
+			add_splitter(smaller, a);
+	}
+
+	vector<int> preimage, touched_blocks;
+	while (!splitters.empty()) {
+		auto [splitter, a] = splitters.back();
+		splitters.pop_back();
+		is_splitter[splitter * k + a] = false;
+
+		preimage.clear();
+		for (int p = block_begin[splitter]; p < block_end[splitter]; p++) {
+			int to = elements[p] * k + a;
+			preimage.insert(preimage.end(),
+							preimages.begin() + preimage_begin[to],
+							preimages.begin() + preimage_begin[to + 1]);
+		}
+		for (int from : preimage) {
+			int b = block_of[from];
+			int marked_position = block_begin[b] + block_marked[b];
+			if (position[from] < marked_position)
+				continue;
+			if (block_marked[b] == 0)
+				touched_blocks.push_back(b);
+			int displaced = elements[marked_position];
+			std::swap(elements[position[from]], elements[marked_position]);
+			position[displaced] = position[from];
+			position[from] = marked_position;
+			block_marked[b]++;
+		}
+
+		for (int b : touched_blocks) {
+			int marked = block_marked[b];
+			block_marked[b] = 0;
+			if (marked == block_size(b))
+				continue;
+			// новым блоком становится меньшая из двух частей
+			int new_block = block_begin.size();
+			if (marked <= block_size(b) - marked) {
+				block_begin.push_back(block_begin[b]);
+				block_end.push_back(block_begin[b] + marked);
+				block_begin[b] += marked;
+			} else {
+				block_begin.push_back(block_begin[b] + marked);
+				block_end.push_back(block_end[b]);
+				block_end[b] = block_begin[b] + marked;
+			}
+			block_marked.push_back(0);
+			for (int p = block_begin[new_block]; p < block_end[new_block]; p++)
+				block_of[elements[p]] = new_block;
+
+			is_splitter.resize(block_begin.size() * k);
+			for (int c = 0; c < k; c++) {
+				if (is_splitter[b * k + c] || block_size(new_block) <= block_size(b))
+					add_splitter(new_block, c);
+				else
+					add_splitter(b, c);
+			}
+		}
+		touched_blocks.clear();
+	}
+
+	// классы нумеруются в том же порядке, что и в табличном алгоритме:
+	// сначала неодноэлементные по второму по величине состоянию, затем одноэлементные
+	vector<vector<int>> members(block_begin.size());
+	for (int i = 0; i < n; i++)
+		members[block_of[i]].push_back(i);
+	vector<pair<int, int>> order;
+	for (int b = 0; b < members.size(); b++) {
+		if (members[b].size() > 1)
+			order.emplace_back(members[b][1], b);
+		else if (members[b].size() == 1)
+			order.emplace_back(n + members[b][0], b);
+	}
+	std::sort(order.begin(), order.end());
+	vector<int> classes(n);
+	for (int i = 0; i < order.size(); i++)
+		for (int state : members[order[i].second])
+			classes[state] = i;
+	return classes;
+}
+
+vector<tuple<int, int, int>> FiniteAutomaton::get_labeled_transitions(const FiniteAutomaton& fa,
+																	  int offset,
+																	  map<Symbol, int>& labels) {
+	vector<tuple<int, int, int>> transitions;
+	for (int i = 0; i < fa.states.size(); i++)
+		for (const auto& [symbol, symbol_transitions] : fa.states[i].transitions) {
+			auto label = labels.emplace(symbol, labels.size()).first->second;
+			for (int to : symbol_transitions)
+				transitions.emplace_back(i + offset, label, to + offset);
+		}
+	return transitions;
+}
+
+vector<int> FiniteAutomaton::get_bisimulation_classes(
+	int n, const vector<tuple<int, int, int>>& transitions, const vector<int>& initial_classes) {
+	int m = transitions.size();
+	int labels_number = 0;
+	for (const auto& [from, label, to] : transitions)
+		labels_number = std::max(labels_number, label + 1);
+
+	// входящие переходы каждого состояния хранятся подряд
+	vector<int> incoming_begin(n + 1, 0);
+	for (const auto& [from, label, to] : transitions)
+		incoming_begin[to + 1]++;
+	for (int i = 1; i <= n; i++)
+		incoming_begin[i] += incoming_begin[i - 1];
+	vector<int> incoming(m);
+	vector<int> filled(incoming_begin.begin(), incoming_begin.end() - 1);
+	for (int t = 0; t < m; t++)
+		incoming[filled[std::get<2>(transitions[t])]++] = t;
+
+	// переходы, упорядоченные по (откуда, метка)
+	vector<int> outgoing(m);
+	for (int t = 0; t < m; t++)
+		outgoing[t] = t;
+	std::sort(outgoing.begin(), outgoing.end(), [&](int t1, int t2) {
+		return std::tie(std::get<0>(transitions[t1]), std::get<1>(transitions[t1])) <
+			   std::tie(std::get<0>(transitions[t2]), std::get<1>(transitions[t2]));
+	});
+
+	// counter_of[t] - номер счётчика числа переходов из from(t) по label(t) в составной блок,
+	// содержащий to(t); вначале составной блок один - всё множество состояний
+	vector<int> counters, counter_of(m);
+	// начальное разбиение: по initial_classes и множеству меток исходящих переходов,
+	// тогда оно устойчиво относительно единственного составного блока
+	vector<vector<int>> signatures(n);
+	for (int i = 0; i < n; i++)
+		signatures[i].push_back(initial_classes[i]);
+	for (int p = 0; p < m; p++) {
+		auto [from, label, to] = transitions[outgoing[p]];
+		if (p == 0 || std::get<0>(transitions[outgoing[p - 1]]) != from ||
+			std::get<1>(transitions[outgoing[p - 1]]) != label) {
+			signatures[from].push_back(label);
+			counters.push_back(0);
+		}
+		counters.back()++;
+		counter_of[outgoing[p]] = counters.size() - 1;
+	}
+
+	// разбиение: элементы каждого блока занимают непрерывный отрезок массива elements,
+	// помеченные при очередном расщеплении элементы переносятся в начало отрезка
+	vector<int> elements(n), position(n), block_of(n);
+	vector<int> block_begin, block_end, block_marked;
+	for (int i = 0; i < n; i++)
+		elements[i] = i;
+	std::sort(elements.begin(), elements.end(), [&](int i, int j) {
+		return std::tie(signatures[i], i) < std::tie(signatures[j], j);
+	});
+	for (int p = 0; p < n; p++) {
+		if (p == 0 || signatures[elements[p]] != signatures[elements[p - 1]]) {
+			if (p)
+				block_end.push_back(p);
+			block_begin.push_back(p);
+			block_marked.push_back(0);
+		}
+		position[elements[p]] = p;
+		block_of[elements[p]] = block_begin.size() - 1;
+	}
+	if (n)
+		block_end.push_back(n);
+	signatures.clear();
+
+	// составные блоки - объединения блоков, относительно которых разбиение устойчиво;
+	// в работе находятся составные блоки, содержащие больше одного блока
+	vector<vector<int>> compound_blocks(1);
+	vector<int> compound_of(block_begin.size(), 0);
+	for (int b = 0; b < block_begin.size(); b++)
+		compound_blocks[0].push_back(b);
+	vector<int> compounds;
+	vector<bool> is_in_work(1, false);
+	auto add_to_work = [&](int c) {
+		if (compound_blocks[c].size() > 1 && !is_in_work[c]) {
+			compounds.push_back(c);
+			is_in_work[c] = true;
+		}
+	};
+	add_to_work(0);
+
+	auto block_size = [&](int b) { return block_end[b] - block_begin[b]; };
+	vector<int> touched_blocks;
+	auto mark = [&](int state) {
+		int b = block_of[state];
+		int marked_position = block_begin[b] + block_marked[b];
+		if (position[state] < marked_position)
+			return;
+		if (block_marked[b] == 0)
+			touched_blocks.push_back(b);
+		int displaced = elements[marked_position];
+		std::swap(elements[position[state]], elements[marked_position]);
+		position[displaced] = position[state];
+		position[state] = marked_position;
+		block_marked[b]++;
+	};
+	auto split_touched = [&]() {
+		for (int b : touched_blocks) {
+			int marked = block_marked[b];
+			block_marked[b] = 0;
+			if (marked == block_size(b))
+				continue;
+			// новым блоком становится меньшая из двух частей
+			int new_block = block_begin.size();
+			if (marked <= block_size(b) - marked) {
+				block_begin.push_back(block_begin[b]);
+				block_end.push_back(block_begin[b] + marked);
+				block_begin[b] += marked;
+			} else {
+				block_begin.push_back(block_begin[b] + marked);
+				block_end.push_back(block_end[b]);
+				block_end[b] = block_begin[b] + marked;
+			}
+			block_marked.push_back(0);
+			for (int p = block_begin[new_block]; p < block_end[new_block]; p++)
+				block_of[elements[p]] = new_block;
+			compound_of.push_back(compound_of[b]);
+			compound_blocks[compound_of[b]].push_back(new_block);
+			add_to_work(compound_of[b]);
+		}
+		touched_blocks.clear();
+	};
+
+	vector<vector<int>> incoming_by_label(labels_number);
+	vector<int> touched_labels, sources, splitter_states;
+	vector<int> count_in_splitter(n, 0), new_counter(n, -1);
+	while (!compounds.empty()) {
+		int compound = compounds.back();
+		auto& blocks = compound_blocks[compound];
+		if (blocks.size() < 2) {
+			compounds.pop_back();
+			is_in_work[compound] = false;
+			continue;
+		}
+		// из составного блока выделяется меньший из двух последних блоков
+		int splitter = blocks.back();
+		if (block_size(blocks[blocks.size() - 2]) < block_size(splitter)) {
+			std::swap(blocks[blocks.size() - 2], blocks.back());
+			splitter = blocks.back();
+		}
+		blocks.pop_back();
+		compound_of[splitter] = compound_blocks.size();
+		compound_blocks.push_back({splitter});
+		is_in_work.push_back(false);
+
+		splitter_states.assign(elements.begin() + block_begin[splitter],
+							   elements.begin() + block_end[splitter]);
+		for (int state : splitter_states)
+			for (int p = incoming_begin[state]; p < incoming_begin[state + 1]; p++) {
+				int label = std::get<1>(transitions[incoming[p]]);
+				if (incoming_by_label[label].empty())
+					touched_labels.push_back(label);
+				incoming_by_label[label].push_back(incoming[p]);
+			}
+
+		for (int label : touched_labels) {
+			vector<int>& label_transitions = incoming_by_label[label];
+			for (int t : label_transitions) {
+				int from = std::get<0>(transitions[t]);
+				if (count_in_splitter[from]++ == 0)
+					sources.push_back(from);
+			}
+			// отделяем состояния, у которых есть переходы по label в splitter
+			for (int from : sources)
+				mark(from);
+			split_touched();
+			// среди них отделяем те, у которых нет переходов по label в остаток составного блока
+			for (int t : label_transitions) {
+				int from = std::get<0>(transitions[t]);
+				if (count_in_splitter[from] == counters[counter_of[t]])
+					mark(from);
+			}
+			split_touched();
+			// переходы в splitter получают собственные счётчики
+			for (int t : label_transitions) {
+				int from = std::get<0>(transitions[t]);
+				if (new_counter[from] == -1) {
+					new_counter[from] = counters.size();
+					counters.push_back(count_in_splitter[from]);
+					counters[counter_of[t]] -= count_in_splitter[from];
+				}
+				counter_of[t] = new_counter[from];
+			}
+			for (int from : sources) {
+				count_in_splitter[from] = 0;
+				new_counter[from] = -1;
+			}
+			sources.clear();
+			label_transitions.clear();
+		}
+		touched_labels.clear();
+	}
+
+	vector<int> classes(n), class_of_block(block_begin.size(), -1);
+	int classes_number = 0;
+	for (int i = 0; i < n; i++) {
+		if (class_of_block[block_of[i]] == -1)
+			class_of_block[block_of[i]] = classes_number++;
+		classes[i] = class_of_block[block_of[i]];
+	}
+	return classes;
+}
+
 FiniteAutomaton FiniteAutomaton::minimize(bool is_trim, iLogTemplate* log) const {
 	if (!is_trim && log)
 		log->set_parameter("trap", " (с добавлением ловушки)");
@@ -276,102 +644,7 @@ FiniteAutomaton FiniteAutomaton::minimize(bool is_trim, iLogTemplate* log) const
 	}
 	// минимизация
 	FiniteAutomaton dfa = determinize();
-	vector<bool> table(dfa.size() * dfa.size());
-	int counter = 1;
-	for (int i = 1; i < dfa.size(); i++) {
-		for (int j = 0; j < counter; j++) {
-			if (dfa.states[i].is_terminal ^ dfa.states[j].is_terminal) {
-				table[i * dfa.size() + j] = true;
-			}
-		}
-		counter++;
-	}
-
-	bool flag = true;
-	while (flag) {
-		counter = 1;
-		flag = false;
-		for (int i = 1; i < dfa.size(); i++) {
-			for (int j = 0; j < counter; j++) {
-				if (!table[i * dfa.size() + j]) {
-					for (const Symbol& symb : language->get_alphabet()) {
-						vector<int> to = {*dfa.states[i].transitions.at(symb).begin(),
-										  *dfa.states[j].transitions.at(symb).begin()};
-						if (*dfa.states[i].transitions.at(symb).begin() <
-							*dfa.states[j].transitions.at(symb).begin()) {
-							to = {*dfa.states[j].transitions.at(symb).begin(),
-								  *dfa.states[i].transitions.at(symb).begin()};
-						}
-						if (table[to[0] * dfa.size() + to[1]]) {
-							table[i * dfa.size() + j] = true;
-							flag = true;
-						}
-					}
-				}
-			}
-			counter++;
-		}
-	}
-
-	set<int> visited;
-	vector<vector<int>> groups;
-	counter = 1;
-	for (int i = 1; i < dfa.size(); i++) {
-		for (int j = 0; j < counter; j++) {
-			if (!table[i * dfa.size() + j]) {
-				groups.push_back({i, j});
-				visited.insert(i);
-				visited.insert(j);
-			}
-		}
-		counter++;
-	}
-
-	counter = 1;
-	for (int i = 0; i >= 0 && i < groups.size(); i++) {
-		for (int j = counter; i >= 0 && j < groups.size(); j++) {
-			bool in_first = false;
-			bool in_second = false;
-			if (find(groups[i].begin(), groups[i].end(), groups[j][0]) != groups[i].end()) {
-				in_first = true;
-			}
-			if (find(groups[i].begin(), groups[i].end(), groups[j][1]) != groups[i].end()) {
-				in_second = true;
-			}
-			if (in_first && in_second) {
-				groups.erase(groups.begin() + j);
-				i--;
-				counter--;
-				continue;
-			}
-			if (in_first) {
-				groups[i].push_back(groups[j][1]);
-				groups.erase(groups.begin() + j);
-				i--;
-				counter--;
-			}
-			if (in_second) {
-				groups[i].push_back(groups[j][0]);
-				groups.erase(groups.begin() + j);
-				i--;
-				counter--;
-			}
-		}
-		counter++;
-	}
-
-	for (int i = 0; i < dfa.size(); i++) {
-		if (visited.find(dfa.states[i].index) == visited.end()) {
-			groups.push_back({dfa.states[i].index});
-		}
-	}
-
-	vector<int> classes(dfa.size());
-	for (int i = 0; i < groups.size(); i++) {
-		for (int j = 0; j < groups[i].size(); j++) {
-			classes[groups[i][j]] = i;
-		}
-	}
+	vector<int> classes = dfa.get_hopcroft_classes();
 	FiniteAutomaton minimized_dfa = dfa.merge_equivalent_classes(classes);
 
 	// кэширование
@@ -386,13 +659,14 @@ FiniteAutomaton FiniteAutomaton::minimize(bool is_trim, iLogTemplate* log) const
 		ss << "\\{" << state.identifier << "\\};";
 	}
 	MetaInfo old_meta, new_meta;
+	vector<int> class_size(dfa.size());
+	for (int class_number : classes)
+		class_size[class_number]++;
 	for (int i = 0; i < dfa.size(); i++) {
-		for (int j = 0; j < dfa.size(); j++)
-			if (classes[i] == classes[j] && (i != j)) {
-				old_meta.upd(NodeMeta{dfa.states[i].index, classes[i]});
-				new_meta.upd(NodeMeta{classes[i], classes[i]});
-				break;
-			}
+		if (class_size[classes[i]] > 1) {
+			old_meta.upd(NodeMeta{dfa.states[i].index, classes[i]});
+			new_meta.upd(NodeMeta{classes[i], classes[i]});
+		}
 	}
 
 	if (log) {
@@ -546,65 +820,97 @@ FiniteAutomaton FiniteAutomaton::remove_eps_additional(iLogTemplate* log) const
 	return new_nfa;
 }
 
-FiniteAutomaton FiniteAutomaton::intersection(const FiniteAutomaton& fa1,
-											  const FiniteAutomaton& fa2, iLogTemplate* log) {
-	Alphabet merged_alphabets = fa1.language->get_alphabet();
-	for (const auto& symb : fa2.language->get_alphabet()) {
-		merged_alphabets.insert(symb);
-	}
-	FiniteAutomaton new_dfa1(fa1.initial_state, fa1.states, merged_alphabets);
-	FiniteAutomaton new_dfa2(fa2.initial_state, fa2.states, merged_alphabets);
-	new_dfa1 = new_dfa1.determinize();
-	new_dfa2 = new_dfa2.determinize();
-	FiniteAutomaton new_dfa(0, {}, merged_alphabets);
-	int counter = 0;
-	vector<pair<int, int>> state_pair; // пары индексов состояний
-	for (const auto& state1 : new_dfa1.states) {
-		for (const auto& state2 : new_dfa2.states) {
-			string new_identifier;
-			new_identifier = state1.identifier.empty() ? "" : state1.identifier;
-			new_identifier += (state2.identifier.empty() ? "" : ", " + state2.identifier);
-			new_dfa.states.push_back({counter,
-									  {state1.index, state2.index},
-									  new_identifier,
-									  state1.is_terminal && state2.is_terminal,
-									  FAState::Transitions()});
-			state_pair.emplace_back(state1.index, state2.index);
-			counter++;
+FiniteAutomaton FiniteAutomaton::get_product(const FiniteAutomaton& fa1,
+											 const FiniteAutomaton& fa2, const Alphabet& alphabet,
+											 bool (*is_terminal)(bool, bool)) {
+	using Index = FATransitionTable::Index;
+	FATransitionTable table1 = fa1.get_transition_table();
+	FATransitionTable table2 = fa2.get_transition_table();
+	// номера символов второго автомата, соответствующие символам первого
+	vector<std::optional<Index>> symbol_in_table2(table1.symbols_count());
+	for (Index symbol = 0; symbol < table1.symbols_count(); symbol++)
+		symbol_in_table2[symbol] = table2.find_symbol(table1.get_symbol(symbol));
+	std::optional<Index> epsilon1 = table1.get_epsilon();
+	std::optional<Index> epsilon2 = table2.get_epsilon();
+
+	// пары состояний нумеруются в порядке обнаружения, необработанные пары
+	// лежат в конце вектора pairs, начиная с позиции i
+	std::unordered_map<pair<int, int>, int, PairHasher> index_by_pair;
+	vector<pair<int, int>> pairs;
+	auto get_index = [&](int state1, int state2) {
+		auto [it, is_new] = index_by_pair.emplace(pair<int, int>(state1, state2), pairs.size());
+		if (is_new)
+			pairs.emplace_back(state1, state2);
+		return it->second;
+	};
+	// переходы произведения: (откуда, символ, куда)
+	vector<tuple<int, const Symbol*, int>> transitions;
+	get_index(fa1.initial_state, fa2.initial_state);
+	for (int i = 0; i < pairs.size(); i++) {
+		auto [state1, state2] = pairs[i];
+		for (Index symbol = 0; symbol < table1.symbols_count(); symbol++) {
+			const Symbol* symb = &table1.get_symbol(symbol);
+			if (symbol == epsilon1) {
+				// eps-переходы каждого из автоматов выполняются независимо
+				for (int to1 : table1.get_transitions(state1, symbol))
+					transitions.emplace_back(i, symb, get_index(to1, state2));
+				continue;
+			}
+			if (!symbol_in_table2[symbol])
+				continue;
+			for (int to1 : table1.get_transitions(state1, symbol))
+				for (int to2 : table2.get_transitions(state2, *symbol_in_table2[symbol]))
+					transitions.emplace_back(i, symb, get_index(to1, to2));
 		}
+		if (epsilon2)
+			for (int to2 : table2.get_transitions(state2, *epsilon2))
+				transitions.emplace_back(i, &table2.get_symbol(*epsilon2), get_index(state1, to2));
 	}
 
-	for (int i = 0; i < new_dfa.size(); i++) {
-		for (const Symbol& symb : new_dfa.language->get_alphabet()) {
-			new_dfa.states[i].transitions[symb].insert(
-				*new_dfa1.states[state_pair[i].first].transitions.at(symb).begin() *
-					new_dfa2.size() +
-				*new_dfa2.states[state_pair[i].second].transitions.at(symb).begin());
-		}
-	}
+	// состояния результата упорядочиваются по парам индексов исходных состояний
+	vector<int> order(pairs.size());
+	for (int i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&](int a, int b) { return pairs[a] < pairs[b]; });
+	vector<int> new_index(pairs.size());
+	vector<FAState> new_states;
+	for (int i = 0; i < order.size(); i++) {
+		new_index[order[i]] = i;
+		const FAState& state1 = fa1.states[pairs[order[i]].first];
+		const FAState& state2 = fa2.states[pairs[order[i]].second];
+		string new_identifier = state1.identifier;
+		new_identifier += (state2.identifier.empty() ? "" : ", " + state2.identifier);
+		new_states.emplace_back(i,
+								set<int>{state1.index, state2.index},
+								new_identifier,
+								is_terminal(state1.is_terminal, state2.is_terminal),
+								FAState::Transitions());
+	}
+	for (const auto& [from, symb, to] : transitions)
+		new_states[new_index[from]].transitions[*symb].insert(new_index[to]);
+
+	return {new_index[0], new_states, alphabet};
+}
+
+FiniteAutomaton FiniteAutomaton::intersection(const FiniteAutomaton& fa1,
+											  const FiniteAutomaton& fa2, iLogTemplate* log) {
 	Alphabet new_alphabet;
 	set_intersection(fa1.language->get_alphabet().begin(),
 					 fa1.language->get_alphabet().end(),
 					 fa2.language->get_alphabet().begin(),
 					 fa2.language->get_alphabet().end(),
 					 inserter(new_alphabet, new_alphabet.begin()));
-	new_dfa.language->set_alphabet(new_alphabet);
-	for (int i = 0; i < new_dfa.size(); i++) {
-		FAState::Transitions new_transitions;
-		for (const Symbol& symb : merged_alphabets) {
-			if (new_dfa.states[i].transitions.find(symb) != new_dfa.states[i].transitions.end()) {
-				new_transitions[symb] = new_dfa.states[i].transitions.at(symb);
-			}
-		}
-		new_dfa.states[i].transitions = new_transitions;
-	}
-	new_dfa = new_dfa.remove_unreachable_states();
+	// пересечение строится по НКА напрямую, без предварительной детерминизации
+	FiniteAutomaton new_fa = get_product(
+		fa1, fa2, new_alphabet, [](bool is_terminal1, bool is_terminal2) {
+			return is_terminal1 && is_terminal2;
+		});
 	if (log) {
 		log->set_parameter("automaton1", fa1);
 		log->set_parameter("automaton2", fa2);
-		log->set_parameter("result", new_dfa);
+		log->set_parameter("result", new_fa);
 	}
-	return new_dfa;
+	return new_fa;
 }
 
 FiniteAutomaton FiniteAutomaton::uunion(const FiniteAutomaton& fa1, const FiniteAutomaton& fa2,
@@ -613,37 +919,15 @@ FiniteAutomaton FiniteAutomaton::uunion(const FiniteAutomaton& fa1, const Finite
 	for (const auto& symb : fa2.language->get_alphabet()) {
 		merged_alphabets.insert(symb);
 	}
+	// для объединения нужны полные ДКА над общим алфавитом
 	FiniteAutomaton new_dfa1(fa1.initial_state, fa1.states, merged_alphabets);
 	FiniteAutomaton new_dfa2(fa2.initial_state, fa2.states, merged_alphabets);
 	new_dfa1 = new_dfa1.determinize();
 	new_dfa2 = new_dfa2.determinize();
-	FiniteAutomaton new_dfa(0, {}, merged_alphabets);
-	int counter = 0;
-	vector<pair<int, int>> state_pair; // пары индексов состояний
-	for (const auto& state1 : new_dfa1.states) {
-		for (const auto& state2 : new_dfa2.states) {
-			string new_identifier;
-			new_identifier = state1.identifier.empty() ? "" : state1.identifier;
-			new_identifier += (state2.identifier.empty() ? "" : ", " + state2.identifier);
-			new_dfa.states.push_back({counter,
-									  {state1.index, state2.index},
-									  new_identifier,
-									  state1.is_terminal || state2.is_terminal,
-									  FAState::Transitions()});
-			state_pair.emplace_back(state1.index, state2.index);
-			counter++;
-		}
-	}
-
-	for (int i = 0; i < new_dfa.size(); i++) {
-		for (const Symbol& symb : new_dfa.language->get_alphabet()) {
-			new_dfa.states[i].transitions[symb].insert(
-				*new_dfa1.states[state_pair[i].first].transitions.at(symb).begin() *
-					new_dfa2.size() +
-				*new_dfa2.states[state_pair[i].second].transitions.at(symb).begin());
-		}
-	}
-	new_dfa = new_dfa.remove_unreachable_states();
+	FiniteAutomaton new_dfa = get_product(
+		new_dfa1, new_dfa2, merged_alphabets, [](bool is_terminal1, bool is_terminal2) {
+			return is_terminal1 || is_terminal2;
+		});
 	if (log) {
 		log->set_parameter("automaton1", fa1);
 		log->set_parameter("automaton2", fa2);
@@ -658,47 +942,15 @@ FiniteAutomaton FiniteAutomaton::difference(const FiniteAutomaton& fa1, const Fi
 	for (const auto& symb : fa2.language->get_alphabet()) {
 		merged_alphabets.insert(symb);
 	}
+	// для разности нужны полные ДКА над общим алфавитом
 	FiniteAutomaton new_dfa1(fa1.initial_state, fa1.states, merged_alphabets);
 	FiniteAutomaton new_dfa2(fa2.initial_state, fa2.states, merged_alphabets);
 	new_dfa1 = new_dfa1.determinize();
 	new_dfa2 = new_dfa2.determinize();
-	FiniteAutomaton new_dfa(0, {}, merged_alphabets);
-	int counter = 0;
-	vector<pair<int, int>> state_pair; // пары индексов состояний
-	for (const auto& state1 : new_dfa1.states) {
-		for (const auto& state2 : new_dfa2.states) {
-			string new_identifier;
-			new_identifier = state1.identifier.empty() ? "" : state1.identifier;
-			new_identifier += (state2.identifier.empty() ? "" : ", " + state2.identifier);
-			new_dfa.states.push_back({counter,
-									  {state1.index, state2.index},
-									  new_identifier,
-									  state1.is_terminal && !state2.is_terminal,
-									  FAState::Transitions()});
-			state_pair.emplace_back(state1.index, state2.index);
-			counter++;
-		}
-	}
-
-	for (int i = 0; i < new_dfa.size(); i++) {
-		for (const Symbol& symb : new_dfa.language->get_alphabet()) {
-			new_dfa.states[i].transitions[symb].insert(
-				*new_dfa1.states[state_pair[i].first].transitions.at(symb).begin() *
-					new_dfa2.size() +
-				*new_dfa2.states[state_pair[i].second].transitions.at(symb).begin());
-		}
-	}
-	new_dfa.language->set_alphabet(fa1.language->get_alphabet());
-	for (int i = 0; i < new_dfa.size(); i++) {
-		FAState::Transitions new_transitions;
-		for (const Symbol& symb : merged_alphabets) {
-			if (new_dfa.states[i].transitions.find(symb) != new_dfa.states[i].transitions.end()) {
-				new_transitions[symb] = new_dfa.states[i].transitions.at(symb);
-			}
-		}
-		new_dfa.states[i].transitions = new_transitions;
-	}
-	new_dfa = new_dfa.remove_unreachable_states();
+	FiniteAutomaton new_dfa = get_product(
+		new_dfa1, new_dfa2, fa1.language->get_alphabet(), [](bool is_terminal1, bool is_terminal2) {
+			return is_terminal1 && !is_terminal2;
+		});
 	if (log) {
 		log->set_parameter("automaton1", fa1);
 		log->set_parameter("automaton2", fa2);
@@ -1376,39 +1628,32 @@ FiniteAutomaton FiniteAutomaton::merge_equivalent_classes(vector<int> classes) c
 }
 
 FiniteAutomaton FiniteAutomaton::merge_bisimilar(iLogTemplate* log) const {
-	vector<RLGrammar::Item> fa_items;
-	vector<RLGrammar::Item*> nonterminals;
-	vector<RLGrammar::Item*> terminals;
-	MetaInfo old_meta, new_meta;
-	vector<vector<vector<RLGrammar::Item*>>> rules = RLGrammar::fa_to_grammar(
-		states, language->get_alphabet(), fa_items, nonterminals, terminals);
-	vector<RLGrammar::Item*> bisimilar_nonterminals;
-	map<int, vector<RLGrammar::Item*>> class_to_nonterminals;
-	vector<vector<vector<RLGrammar::Item*>>> bisimilar_rules = RLGrammar::get_bisimilar_grammar(
-		rules, nonterminals, bisimilar_nonterminals, class_to_nonterminals);
-
-	// log
-	vector<int> classes;
-	for (const auto& nont : nonterminals)
-		classes.push_back(nont->class_number);
+	map<Symbol, int> labels;
+	vector<int> initial_classes(states.size());
+	for (int i = 0; i < states.size(); i++)
+		initial_classes[i] = states[i].is_terminal;
+	vector<int> classes = get_bisimulation_classes(
+		states.size(), get_labeled_transitions(*this, 0, labels), initial_classes);
 	FiniteAutomaton result_fa = merge_equivalent_classes(classes);
 
-	for (int i = 0; i < classes.size(); i++) {
-		for (int j = 0; j < classes.size(); j++)
-			if (classes[i] == classes[j] && (i != j)) {
+	if (log) {
+		MetaInfo old_meta, new_meta;
+		vector<vector<int>> class_members(result_fa.size());
+		for (int i = 0; i < classes.size(); i++)
+			class_members[classes[i]].push_back(i);
+		for (int i = 0; i < classes.size(); i++)
+			if (class_members[classes[i]].size() > 1) {
 				old_meta.upd(NodeMeta{i, classes[i]});
 				new_meta.upd(NodeMeta{classes[i], classes[i]});
 			}
-	}
 
-	stringstream ss;
-	for (auto& elem : class_to_nonterminals) {
-		ss << "\\{";
-		for (int i = 0; i < elem.second.size() - 1; i++)
-			ss << elem.second[i]->name << ",\\ ";
-		ss << elem.second[elem.second.size() - 1]->name << "\\};";
-	}
-	if (log) {
+		stringstream ss;
+		for (const auto& members : class_members) {
+			ss << "\\{";
+			for (int i = 0; i < members.size() - 1; i++)
+				ss << states[members[i]].identifier << ",\\ ";
+			ss << states[members.back()].identifier << "\\};";
+		}
 		log->set_parameter("oldautomaton", *this, old_meta);
 		log->set_parameter("equivclasses", ss.str()); // TODO: logs
 		log->set_parameter("result", result_fa, new_meta);
@@ -1417,90 +1662,29 @@ FiniteAutomaton FiniteAutomaton::merge_bisimilar(iLogTemplate* log) const {
 }
 
 bool FiniteAutomaton::bisimilarity_checker(const FiniteAutomaton& fa1, const FiniteAutomaton& fa2) {
-	// грамматики из автоматов
-	vector<RLGrammar::Item> fa1_items;
-	vector<RLGrammar::Item*> fa1_nonterminals;
-	vector<RLGrammar::Item*> fa1_terminals;
-	vector<vector<vector<RLGrammar::Item*>>> fa1_rules = RLGrammar::fa_to_grammar(
-		fa1.states, fa1.language->get_alphabet(), fa1_items, fa1_nonterminals, fa1_terminals);
-
-	vector<RLGrammar::Item> fa2_items;
-	vector<RLGrammar::Item*> fa2_nonterminals;
-	vector<RLGrammar::Item*> fa2_terminals;
-	vector<vector<vector<RLGrammar::Item*>>> fa2_rules = RLGrammar::fa_to_grammar(
-		fa2.states, fa2.language->get_alphabet(), fa2_items, fa2_nonterminals, fa2_terminals);
-
-	if (fa1_terminals.size() != fa2_terminals.size())
-		return false;
-	for (int i = 0; i < fa1_terminals.size(); i++)
-		if (*fa1_terminals[i] != *fa2_terminals[i])
-			return false;
-	// сначала получаем бисимилярные грамматики из данных автоматов
-	vector<RLGrammar::Item*> fa1_bisimilar_nonterminals;
-	map<int, vector<RLGrammar::Item*>> fa1_class_to_nonterminals;
-	vector<vector<vector<RLGrammar::Item*>>> fa1_bisimilar_rules = RLGrammar::get_bisimilar_grammar(
-		fa1_rules, fa1_nonterminals, fa1_bisimilar_nonterminals, fa1_class_to_nonterminals);
-
-	vector<RLGrammar::Item*> fa2_bisimilar_nonterminals;
-	map<int, vector<RLGrammar::Item*>> fa2_class_to_nonterminals;
-	vector<vector<vector<RLGrammar::Item*>>> fa2_bisimilar_rules = RLGrammar::get_bisimilar_grammar(
-		fa2_rules, fa2_nonterminals, fa2_bisimilar_nonterminals, fa2_class_to_nonterminals);
-	if (fa1_bisimilar_nonterminals.size() != fa2_bisimilar_nonterminals.size())
+	if (fa1.language->get_alphabet() != fa2.language->get_alphabet())
 		return false;
-	// из объединения полученных ранее получаем итоговую
-	vector<RLGrammar::Item*> nonterminals(fa1_bisimilar_nonterminals);
-	nonterminals.insert(
-		nonterminals.end(), fa2_bisimilar_nonterminals.begin(), fa2_bisimilar_nonterminals.end());
-	vector<vector<vector<RLGrammar::Item*>>> rules(fa1_bisimilar_rules);
-	rules.insert(rules.end(), fa2_bisimilar_rules.begin(), fa2_bisimilar_rules.end());
-
-	vector<int> fa1_classes; // сохраняю классы
-	for (RLGrammar::Item* nont : fa1_nonterminals) {
-		fa1_classes.push_back(nont->class_number);
-		nont->class_number = -1; // сбрасываю номера классов
-	}
-	vector<int> fa2_classes; // сохраняю классы
-	for (RLGrammar::Item* nont : fa2_nonterminals) {
-		fa2_classes.push_back(nont->class_number);
-		nont->class_number = -1; // сбрасываю номера классов
-	}
-
-	vector<RLGrammar::Item*> bisimilar_nonterminals;
-	map<int, vector<RLGrammar::Item*>> class_to_nonterminals;
-	vector<vector<vector<RLGrammar::Item*>>> bisimilar_rules = RLGrammar::get_bisimilar_grammar(
-		rules, nonterminals, bisimilar_nonterminals, class_to_nonterminals);
-
-	map<int, vector<string>> class_to_nonterminals_names;
-
-	for (int i = 0; i < fa1_nonterminals.size(); i++) {
-		int nont_class = fa1_class_to_nonterminals[fa1_classes[i]][0]
-							 ->class_number; // класс нетерминала в общей грамматике, 0й
-											 // элемент попал в бисимилярную грамматику
-		class_to_nonterminals_names[nont_class].push_back("FA1:" + fa1_nonterminals[i]->name);
-	}
-
-	for (int i = 0; i < fa2_nonterminals.size(); i++) {
-		int nont_class = fa2_class_to_nonterminals[fa2_classes[i]][0]
-							 ->class_number; // класс нетерминала в общей грамматике, 0й
-											 // элемент попал в бисимилярную грамматику
-		class_to_nonterminals_names[nont_class].push_back("FA2:" + fa2_nonterminals[i]->name);
-	}
-	// log
-	stringstream ss;
-	for (auto& elem : class_to_nonterminals_names) {
-		ss << "\\{";
-		for (int i = 0; i < elem.second.size() - 1; i++)
-			ss << elem.second[i] << ",";
-		ss << elem.second[elem.second.size() - 1] << "\\}";
-	}
+	// бисимуляция на дизъюнктном объединении автоматов, состояния fa2 идут после состояний fa1
+	int n1 = fa1.size(), n = fa1.size() + fa2.size();
+	map<Symbol, int> labels;
+	vector<tuple<int, int, int>> transitions = get_labeled_transitions(fa1, 0, labels);
+	vector<tuple<int, int, int>> fa2_transitions = get_labeled_transitions(fa2, n1, labels);
+	transitions.insert(transitions.end(), fa2_transitions.begin(), fa2_transitions.end());
+	vector<int> initial_classes(n);
+	for (int i = 0; i < n; i++)
+		initial_classes[i] = i < n1 ? fa1.states[i].is_terminal : fa2.states[i - n1].is_terminal;
+	vector<int> classes = get_bisimulation_classes(n, transitions, initial_classes);
 
 	// проверяю равенство классов начальных состояний
-	if (fa1_nonterminals[fa1.initial_state]->class_number !=
-		fa2_nonterminals[fa2.initial_state]->class_number)
-		return false;
-	if (fa1_bisimilar_nonterminals.size() != bisimilar_nonterminals.size())
+	if (classes[fa1.initial_state] != classes[n1 + fa2.initial_state])
 		return false;
-
+	// каждый класс должен содержать состояния обоих автоматов
+	vector<bool> in_fa1(n, false), in_fa2(n, false);
+	for (int i = 0; i < n; i++)
+		(i < n1 ? in_fa1 : in_fa2)[classes[i]] = true;
+	for (int i = 0; i < n; i++)
+		if (in_fa1[classes[i]] != in_fa2[classes[i]])
+			return false;
 	return true;
 }
 
@@ -1519,144 +1703,86 @@ bool FiniteAutomaton::equality_checker(const FiniteAutomaton& fa1, const FiniteA
 	// проверка равенства количества состояний
 	if (fa1.size() != fa2.size())
 		return false;
-	// грамматики из состояний автоматов
-	vector<RLGrammar::Item> fa1_items;
-	vector<RLGrammar::Item*> fa1_nonterminals;
-	vector<RLGrammar::Item*> fa1_terminals;
-	vector<vector<vector<RLGrammar::Item*>>> fa1_rules = RLGrammar::fa_to_grammar(
-		fa1.states, fa1.language->get_alphabet(), fa1_items, fa1_nonterminals, fa1_terminals);
-
-	vector<RLGrammar::Item> fa2_items;
-	vector<RLGrammar::Item*> fa2_nonterminals;
-	vector<RLGrammar::Item*> fa2_terminals;
-	vector<vector<vector<RLGrammar::Item*>>> fa2_rules = RLGrammar::fa_to_grammar(
-		fa2.states, fa2.language->get_alphabet(), fa2_items, fa2_nonterminals, fa2_terminals);
 	// проверка на равенство алфавитов
-	if (fa1_terminals.size() != fa2_terminals.size())
+	if (fa1.language->get_alphabet() != fa2.language->get_alphabet())
 		return false;
-	for (int i = 0; i < fa1_terminals.size(); i++)
-		if (*fa1_terminals[i] != *fa2_terminals[i])
-			return false;
+	// состояния fa2 идут после состояний fa1
+	int n1 = fa1.size(), n = fa1.size() + fa2.size();
+	auto state = [&](int i) -> const FAState& {
+		return i < n1 ? fa1.states[i] : fa2.states[i - n1];
+	};
+	auto is_balanced = [](const vector<int>& classes) {
+		vector<int> balance(classes.size(), 0);
+		for (int i = 0; i < classes.size(); i++)
+			balance[classes[i]] += i < classes.size() / 2 ? 1 : -1;
+		for (int t : balance)
+			if (t != 0)
+				return false;
+		return true;
+	};
+
 	// биективная бисимуляция состояний
-	vector<RLGrammar::Item*> nonterminals(fa1_nonterminals);
-	nonterminals.insert(nonterminals.end(), fa2_nonterminals.begin(), fa2_nonterminals.end());
-	vector<vector<vector<RLGrammar::Item*>>> rules(fa1_rules);
-	rules.insert(rules.end(), fa2_rules.begin(), fa2_rules.end());
-	for (RLGrammar::Item* nont : nonterminals)
-		nont->class_number = 0; // сбрасываю номера классов
-	vector<RLGrammar::Item*> bisimilar_nonterminals;
-	map<int, vector<RLGrammar::Item*>> class_to_nonterminals;
-	vector<vector<vector<RLGrammar::Item*>>> bisimilar_rules = RLGrammar::get_bisimilar_grammar(
-		rules, nonterminals, bisimilar_nonterminals, class_to_nonterminals);
+	map<Symbol, int> labels;
+	vector<tuple<int, int, int>> transitions = get_labeled_transitions(fa1, 0, labels);
+	vector<tuple<int, int, int>> fa2_transitions = get_labeled_transitions(fa2, n1, labels);
+	transitions.insert(transitions.end(), fa2_transitions.begin(), fa2_transitions.end());
+	vector<int> initial_classes(n);
+	for (int i = 0; i < n; i++)
+		initial_classes[i] = state(i).is_terminal;
+	vector<int> bisimilar_classes = get_bisimulation_classes(n, transitions, initial_classes);
 	// проверяю равенство классов начальных состояний
-	if (fa1_nonterminals[fa1.initial_state]->class_number !=
-		fa2_nonterminals[fa2.initial_state]->class_number)
+	if (bisimilar_classes[fa1.initial_state] != bisimilar_classes[n1 + fa2.initial_state])
 		return false;
 	// проверяю бисимилярность состояний
-	vector<int> classes(bisimilar_nonterminals.size(), 0);
-	for (RLGrammar::Item* nont : fa1_nonterminals)
-		classes[nont->class_number]++;
-	for (RLGrammar::Item* nont : fa2_nonterminals)
-		classes[nont->class_number]--;
-	for (auto t : classes)
-		if (t != 0)
-			return false;
+	if (!is_balanced(bisimilar_classes))
+		return false;
 
-	vector<int> bisimilar_classes(nonterminals.size());
-	for (int i = 0; i < nonterminals.size(); i++)
-		bisimilar_classes[i] = nonterminals[i]->class_number;
-
-	// биективная бисимуляция обратных грамматик
-	vector<vector<vector<RLGrammar::Item*>>> fa1_reverse_rules = RLGrammar::get_reverse_grammar(
-		fa1_rules, fa1_nonterminals, fa1_terminals, fa1.initial_state);
-	vector<vector<vector<RLGrammar::Item*>>> fa2_reverse_rules = RLGrammar::get_reverse_grammar(
-		fa2_rules, fa2_nonterminals, fa2_terminals, fa2.initial_state);
-
-	vector<vector<vector<RLGrammar::Item*>>> reverse_rules(fa1_reverse_rules);
-	reverse_rules.insert(reverse_rules.end(), fa2_reverse_rules.begin(), fa2_reverse_rules.end());
-	for (RLGrammar::Item* nont : nonterminals)
-		nont->class_number = -1; // сбрасываю номера классов
-
-	vector<RLGrammar::Item*> reverse_bisimilar_nonterminals;
-	vector<vector<vector<RLGrammar::Item*>>> reverse_bisimilar_rules =
-		RLGrammar::get_bisimilar_grammar(
-			reverse_rules, nonterminals, reverse_bisimilar_nonterminals, class_to_nonterminals);
-	// сопоставление состояний 1 к 1
-	vector<int> reverse_bisimilar_classes;
-	for (RLGrammar::Item* nont : nonterminals) {
-		reverse_bisimilar_classes.push_back(nont->class_number);
-		nont->class_number = -1;
-	}
-
-	// устанавливаем классы нетерминалов-состояний (1 к 1), чтобы после сопоставить переходы
-	int new_class = 0;
-	for (int i = 0; i < bisimilar_classes.size(); i++) {
-		if (nonterminals[i]->class_number != -1)
-			continue;
-		nonterminals[i]->class_number = new_class;
-		vector<int> equiv_nont; // нетерминалы с таким же классом, что и i-й
-		for (int j = i + 1; j < bisimilar_classes.size(); j++) {
-			if (bisimilar_classes[j] == bisimilar_classes[i])
-				equiv_nont.push_back(j);
-		}
-		for (int ind : equiv_nont)
-			if (reverse_bisimilar_classes[ind] == reverse_bisimilar_classes[i])
-				nonterminals[ind]->class_number = new_class;
-		new_class++;
-	}
-
-	// грамматики из переходов
-	vector<pair<RLGrammar::Item, map<Symbol, vector<RLGrammar::Item>>>> transitions1_items;
-	vector<RLGrammar::Item*> transitions1_nonterminals;
-	vector<RLGrammar::Item*> transitions1_terminals;
-	vector<vector<vector<RLGrammar::Item*>>> transitions1_rules =
-		RLGrammar::tansitions_to_grammar(fa1.states,
-										 fa1_nonterminals,
-										 transitions1_items,
-										 transitions1_nonterminals,
-										 transitions1_terminals);
-
-	vector<pair<RLGrammar::Item, map<Symbol, vector<RLGrammar::Item>>>> transitions2_items;
-	vector<RLGrammar::Item*> transitions2_nonterminals;
-	vector<RLGrammar::Item*> transitions2_terminals;
-	vector<vector<vector<RLGrammar::Item*>>> transitions2_rules =
-		RLGrammar::tansitions_to_grammar(fa2.states,
-										 fa2_nonterminals,
-										 transitions2_items,
-										 transitions2_nonterminals,
-										 transitions2_terminals);
-
-	// проверка равенства количества переходов
-	if (transitions1_nonterminals.size() != transitions2_nonterminals.size())
+	// биективная бисимуляция обратных автоматов
+	vector<tuple<int, int, int>> reverse_transitions;
+	for (const auto& [from, label, to] : transitions)
+		reverse_transitions.emplace_back(to, label, from);
+	for (int i = 0; i < n; i++)
+		initial_classes[i] = i == fa1.initial_state || i == n1 + fa2.initial_state;
+	vector<int> reverse_bisimilar_classes =
+		get_bisimulation_classes(n, reverse_transitions, initial_classes);
+
+	// классы состояний (1 к 1), чтобы после сопоставить переходы
+	map<pair<int, int>, int> pair_classes;
+	vector<int> classes(n);
+	for (int i = 0; i < n; i++)
+		classes[i] = pair_classes
+						 .emplace(pair(bisimilar_classes[i], reverse_bisimilar_classes[i]),
+								  pair_classes.size())
+						 .first->second;
+
+	// автомат из переходов: переход i->t ведёт в переходы, выходящие из t, с меткой класса t;
+	// переходы, после которых нет продолжений и t не финальное, неразличимы между собой
+	vector<int> transition_begin(n + 1, 0);
+	for (const auto& [from, label, to] : transitions)
+		transition_begin[from + 1]++;
+	for (int i = 1; i <= n; i++)
+		transition_begin[i] += transition_begin[i - 1];
+	int transitions_number = transitions.size();
+	if (transition_begin[n1] * 2 != transitions_number)
 		return false;
-	// биективная бисимуляция переходов
-	vector<RLGrammar::Item*> transitions_nonterminals(transitions1_nonterminals);
-	transitions_nonterminals.insert(transitions_nonterminals.end(),
-									transitions2_nonterminals.begin(),
-									transitions2_nonterminals.end());
-	vector<vector<vector<RLGrammar::Item*>>> transitions_rules(transitions1_rules);
-	transitions_rules.insert(
-		transitions_rules.end(), transitions2_rules.begin(), transitions2_rules.end());
-	for (RLGrammar::Item* nont : transitions_nonterminals)
-		nont->class_number = 0; // сбрасываю номера классов
-	vector<RLGrammar::Item*> transitions_bisimilar_nonterminals;
-	vector<vector<vector<RLGrammar::Item*>>> transitions_bisimilar_rules =
-		RLGrammar::get_bisimilar_grammar(transitions_rules,
-										 transitions_nonterminals,
-										 transitions_bisimilar_nonterminals,
-										 class_to_nonterminals);
+	// переходы упорядочены по исходному состоянию, переходы fa1 идут первыми
+	vector<int> transition_target(transitions_number);
+	vector<int> filled(transition_begin.begin(), transition_begin.end() - 1);
+	for (const auto& [from, label, to] : transitions)
+		transition_target[filled[from]++] = to;
+
+	vector<tuple<int, int, int>> transitions_graph;
+	vector<int> transitions_initial_classes(transitions_number);
+	for (int t = 0; t < transitions_number; t++) {
+		int to = transition_target[t];
+		for (int next = transition_begin[to]; next < transition_begin[to + 1]; next++)
+			transitions_graph.emplace_back(t, classes[to], next);
+		bool has_rules = state(to).is_terminal || transition_begin[to] < transition_begin[to + 1];
+		transitions_initial_classes[t] = has_rules ? 2 * classes[to] + state(to).is_terminal : -1;
+	}
 	// проверяю бисимилярность переходов
-	classes.clear();
-	classes.resize(transitions_bisimilar_nonterminals.size(), 0);
-	for (auto t : transitions1_nonterminals)
-		classes[t->class_number]++;
-	for (auto t : transitions2_nonterminals)
-		classes[t->class_number]--;
-	for (auto t : classes)
-		if (t != 0)
-			return false;
-
-	return true;
+	return is_balanced(get_bisimulation_classes(
+		transitions_number, transitions_graph, transitions_initial_classes));
 }
 
 bool FiniteAutomaton::equal(const FiniteAutomaton& fa1, const FiniteAutomaton& fa2,
@@ -1670,6 +1796,141 @@ bool FiniteAutomaton::equal(const FiniteAutomaton& fa1, const FiniteAutomaton& f
 	return result;
 }
 
+std::optional<vector<Symbol>> FiniteAutomaton::get_distinguishing_word(
+	const FiniteAutomaton& fa1, const FiniteAutomaton& fa2) {
+	using Index = FATransitionTable::Index;
+	// детерминизация объединения автоматов "на лету": состояния второго автомата
+	// сдвинуты на fa1.size(), макросостояния - отсортированные eps-замкнутые подмножества
+	FATransitionTable table1 = fa1.get_transition_table();
+	FATransitionTable table2 = fa2.get_transition_table();
+	FAEpsClosures eps_closures1(table1), eps_closures2(table2);
+	int shift = fa1.size();
+	vector<Symbol> symbols;
+	vector<pair<std::optional<Index>, std::optional<Index>>> symbol_indices;
+	for (Index symbol = 0; symbol < table1.symbols_count(); symbol++)
+		if (symbol != table1.get_epsilon()) {
+			symbols.push_back(table1.get_symbol(symbol));
+			symbol_indices.emplace_back(symbol, table2.find_symbol(symbols.back()));
+		}
+	for (Index symbol = 0; symbol < table2.symbols_count(); symbol++)
+		if (symbol != table2.get_epsilon() && !table1.find_symbol(table2.get_symbol(symbol))) {
+			symbols.push_back(table2.get_symbol(symbol));
+			symbol_indices.emplace_back(std::nullopt, symbol);
+		}
+
+	vector<int> targets1, targets2;
+	auto get_post = [&](const vector<int>& subset, int symbol) {
+		targets1.clear();
+		targets2.clear();
+		auto [symbol1, symbol2] = symbol_indices[symbol];
+		for (int state : subset) {
+			if (state < shift && symbol1) {
+				auto targets = table1.get_transitions(state, *symbol1);
+				targets1.insert(targets1.end(), targets.begin(), targets.end());
+			} else if (state >= shift && symbol2) {
+				auto targets = table2.get_transitions(state - shift, *symbol2);
+				targets2.insert(targets2.end(), targets.begin(), targets.end());
+			}
+		}
+		vector<int> post = eps_closures1.get_closure(targets1);
+		for (int state : eps_closures2.get_closure(targets2))
+			post.push_back(state + shift);
+		return post;
+	};
+	auto is_terminal = [&](const vector<int>& subset) {
+		return std::any_of(subset.begin(), subset.end(), [&](int state) {
+			return state < shift ? fa1.states[state].is_terminal
+								 : fa2.states[state - shift].is_terminal;
+		});
+	};
+
+	// Для ДКА отношение R замыкается до эквивалентности системой непересекающихся
+	// множеств (Хопкрофт-Карп), для НКА - до конгруэнции относительно объединения
+	// (bisimulation up to congruence, Бонки-Пус): пара (X, Y) пропускается, если
+	// нормальные формы X и Y по правилам переписывания из R совпадают
+	bool use_congruence = !fa1.is_deterministic() || !fa2.is_deterministic();
+	std::unordered_map<vector<int>, int, FASubsetHasher> subset_index;
+	vector<int> parent;
+	auto find = [&](const vector<int>& subset) {
+		auto [it, is_new] = subset_index.emplace(subset, parent.size());
+		if (is_new)
+			parent.push_back(it->second);
+		int root = it->second;
+		while (parent[root] != root)
+			root = parent[root] = parent[parent[root]];
+		return root;
+	};
+	vector<pair<vector<int>, vector<int>>> relation;
+	vector<char> in_normal_form(shift + fa2.size());
+	auto get_normal_form = [&](const vector<int>& subset) {
+		std::fill(in_normal_form.begin(), in_normal_form.end(), 0);
+		for (int state : subset)
+			in_normal_form[state] = 1;
+		auto contains = [&](const vector<int>& other) {
+			return std::all_of(
+				other.begin(), other.end(), [&](int state) { return in_normal_form[state]; });
+		};
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (const auto& [left, right] : relation) {
+				bool contains_left = contains(left), contains_right = contains(right);
+				if (contains_left == contains_right)
+					continue;
+				for (int state : contains_left ? right : left)
+					in_normal_form[state] = 1;
+				changed = true;
+			}
+		}
+		return in_normal_form;
+	};
+
+	// обход в ширину: первая найденная различимая пара даёт кратчайшее слово
+	struct Item {
+		vector<int> subset1;
+		vector<int> subset2;
+		int parent;
+		int symbol;
+	};
+	vector<Item> items;
+	vector<int> initial2;
+	for (int state : eps_closures2.get_closure(vector<int>{fa2.initial_state}))
+		initial2.push_back(state + shift);
+	items.push_back({eps_closures1.get_closure(vector<int>{fa1.initial_state}), initial2, -1, -1});
+	for (int i = 0; i < items.size(); i++) {
+		const vector<int>& subset1 = items[i].subset1;
+		const vector<int>& subset2 = items[i].subset2;
+		if (use_congruence) {
+			if (get_normal_form(subset1) == get_normal_form(subset2))
+				continue;
+		} else {
+			int root1 = find(subset1), root2 = find(subset2);
+			if (root1 == root2)
+				continue;
+			parent[root1] = root2;
+		}
+
+		if (is_terminal(subset1) != is_terminal(subset2)) {
+			vector<Symbol> word;
+			for (int j = i; items[j].parent != -1; j = items[j].parent)
+				word.push_back(symbols[items[j].symbol]);
+			std::reverse(word.begin(), word.end());
+			return word;
+		}
+		if (use_congruence)
+			relation.emplace_back(subset1, subset2);
+		for (int symbol = 0; symbol < symbols.size(); symbol++) {
+			// ссылки на элемент items становятся недействительными при добавлении
+			Item next{get_post(items[i].subset1, symbol),
+					  get_post(items[i].subset2, symbol),
+					  i,
+					  symbol};
+			items.push_back(std::move(next));
+		}
+	}
+	return std::nullopt;
+}
+
 bool FiniteAutomaton::equivalent(const FiniteAutomaton& fa1, const FiniteAutomaton& fa2,
 								 iLogTemplate* log) {
 	bool result = true;
@@ -1679,11 +1940,18 @@ bool FiniteAutomaton::equivalent(const FiniteAutomaton& fa1, const FiniteAutomat
 			log->set_parameter("samelanguage",
 							   "(!) автоматы изначально принадлежат одному языку"); // TODO:
 																					// logs
+	} else if (fa1.language && fa2.language &&
+			   fa1.language->get_alphabet() != fa2.language->get_alphabet()) {
+		// как и прежде при сравнении минимальных ДКА, автоматы над разными алфавитами
+		// не эквивалентны
+		result = false;
 	} else {
-		if ((!fa1.language->is_min_dfa_cached() || !fa2.language->is_min_dfa_cached()) && log) {
-			log->set_parameter("cachedMINDFA", "Минимальные автоматы сохранены в кэше");
-		}
-		result = equal(fa1.minimize(), fa2.minimize());
+		std::optional<vector<Symbol>> word = get_distinguishing_word(fa1, fa2);
+		result = !word.has_value();
+		if (log && word.has_value())
+			log->set_parameter("distinguishingword",
+							   "Кратчайшее различающее слово: " +
+								   (word->empty() ? Symbol::Epsilon : Symbol::vector_to_str(*word)));
 	}
 	if (log) {
 		log->set_parameter("automaton1", fa1);
@@ -1693,9 +1961,76 @@ bool FiniteAutomaton::equivalent(const FiniteAutomaton& fa1, const FiniteAutomat
 	return result;
 }
 
+bool FiniteAutomaton::inclusion_checker(const FiniteAutomaton& fa1, const FiniteAutomaton& fa2) {
+	using Index = FATransitionTable::Index;
+	FATransitionTable table1 = fa1.get_transition_table();
+	FATransitionTable table2 = fa2.get_transition_table();
+	FAEpsClosures eps_closures2(table2);
+	vector<std::optional<Index>> symbol_in_table2(table1.symbols_count());
+	for (Index symbol = 0; symbol < table1.symbols_count(); symbol++)
+		symbol_in_table2[symbol] = table2.find_symbol(table1.get_symbol(symbol));
+	std::optional<Index> epsilon1 = table1.get_epsilon();
+
+	// пара (q, S) означает, что по некоторому слову первый автомат может попасть в q,
+	// а второй - ровно в множество S. Если q терминально, а в S нет терминальных, то
+	// слово - контрпример. Пара (q, S) поглощает (q, S') при S ⊆ S', поэтому для каждого q
+	// хранится антицепь минимальных по включению множеств
+	vector<vector<vector<int>>> antichains(fa1.size());
+	std::queue<pair<int, vector<int>>> queue;
+	auto add_pair = [&](int state1, vector<int> subset2) {
+		vector<vector<int>>& antichain = antichains[state1];
+		for (const auto& other : antichain)
+			if (std::includes(subset2.begin(), subset2.end(), other.begin(), other.end()))
+				return true;
+		if (fa1.states[state1].is_terminal &&
+			std::none_of(subset2.begin(), subset2.end(), [&](int state2) {
+				return fa2.states[state2].is_terminal;
+			}))
+			return false;
+		antichain.erase(std::remove_if(antichain.begin(),
+									   antichain.end(),
+									   [&](const vector<int>& other) {
+										   return std::includes(other.begin(),
+																other.end(),
+																subset2.begin(),
+																subset2.end());
+									   }),
+						antichain.end());
+		antichain.push_back(subset2);
+		queue.emplace(state1, std::move(subset2));
+		return true;
+	};
+
+	if (!add_pair(fa1.initial_state, eps_closures2.get_closure(vector<int>{fa2.initial_state})))
+		return false;
+	vector<int> post;
+	while (!queue.empty()) {
+		auto [state1, subset2] = std::move(queue.front());
+		queue.pop();
+		for (Index symbol = 0; symbol < table1.symbols_count(); symbol++) {
+			if (table1.get_transitions(state1, symbol).empty())
+				continue;
+			vector<int> next_subset2;
+			if (symbol == epsilon1) {
+				next_subset2 = subset2;
+			} else if (symbol_in_table2[symbol]) {
+				post.clear();
+				for (int state2 : subset2) {
+					auto targets = table2.get_transitions(state2, *symbol_in_table2[symbol]);
+					post.insert(post.end(), targets.begin(), targets.end());
+				}
+				next_subset2 = eps_closures2.get_closure(post);
+			}
+			for (int to1 : table1.get_transitions(state1, symbol))
+				if (!add_pair(to1, next_subset2))
+					return false;
+		}
+	}
+	return true;
+}
+
 bool FiniteAutomaton::subset(const FiniteAutomaton& fa, iLogTemplate* log) const {
-	FiniteAutomaton fa_instersection(intersection(*this, fa));
-	bool result = equivalent(fa_instersection, fa);
+	bool result = inclusion_checker(fa, *this);
 	if (log) {
 		log->set_parameter("automaton1", *this);
 		log->set_parameter("automaton2", fa);
@@ -1706,21 +2041,20 @@ bool FiniteAutomaton::subset(const FiniteAutomaton& fa, iLogTemplate* log) const
 
 Fraction calc_ambiguity(int i, int n, const vector<Fraction>& f1,
 						vector<vector<Fraction>>& calculated,  // NOLINT(runtime/references)
-						vector<vector<char>>& is_calculated) { // NOLINT(runtime/references)
+						vector<vector<char>>& is_calculated,   // NOLINT(runtime/references)
+						Fraction::Context& context) {		   // NOLINT(runtime/references)
 	if (i == 0)
 		return f1[n];
-	Fraction d1, d2;
 	if (!is_calculated[i][n + 1]) {
-		calculated[i][n + 1] = calc_ambiguity(i - 1, n + 1, f1, calculated, is_calculated);
+		calculated[i][n + 1] =
+			calc_ambiguity(i - 1, n + 1, f1, calculated, is_calculated, context);
 		is_calculated[i][n + 1] = 1;
 	}
-	d1 = calculated[i][n + 1];
 	if (!is_calculated[i][n]) {
-		calculated[i][n] = calc_ambiguity(i - 1, n, f1, calculated, is_calculated);
+		calculated[i][n] = calc_ambiguity(i - 1, n, f1, calculated, is_calculated, context);
 		is_calculated[i][n] = 1;
 	}
-	d2 = calculated[i][n];
-	return d1 - d2;
+	return calculated[i][n + 1].subtract(calculated[i][n], context);
 }
 
 FiniteAutomaton::AmbiguityValue FiniteAutomaton::get_ambiguity_value(
@@ -1731,27 +2065,20 @@ FiniteAutomaton::AmbiguityValue FiniteAutomaton::get_ambiguity_value(
 
 	int i = 2;
 	int s = fa.size();
-	int min_s = min_fa.size();
 	int N = s * s + s + i + 1;
 	// количество путей до финальных из начального
 	InfInt paths_number;
 	InfInt min_paths_number;
-	// матрица смежности
-	vector<vector<int>> adjacency_matrix(s, vector<int>(s));
-	vector<vector<int>> min_adjacency_matrix(min_s, vector<int>(min_s));
-	// количество путей длины n до всех вершин из начальной
-	vector<vector<InfInt>> d(2, vector<InfInt>(s));
-	vector<vector<InfInt>> min_d(2, vector<InfInt>(min_s));
-	d[0][fa.initial_state] = 1;
-	min_d[0][min_fa.initial_state] = 1;
-	for (int i = 0; i < s; i++)
-		for (const auto& elem : fa.states[i].transitions)
-			for (int transition : elem.second)
-				adjacency_matrix[i][transition]++;
-	for (int i = 0; i < min_s; i++)
-		for (const auto& elem : min_fa.states[i].transitions)
-			for (int transition : elem.second)
-				min_adjacency_matrix[i][transition]++;
+	// количества путей длины k + 1 считаются пачками, для НКА и минимального ДКА - в
+	// параллельных потоках, если автоматы достаточно велики
+	PathCounter counter(fa), min_counter(min_fa);
+	vector<InfInt> paths_numbers, min_paths_numbers;
+	const int batch_size = 32;
+	bool is_parallel = fa.get_transition_table().transitions_count() >= 1000;
+	auto count_batch = [](PathCounter& c, vector<InfInt>& numbers) { // NOLINT(runtime/references)
+		for (int j = 0; j < batch_size; j++)
+			numbers.push_back(c.next());
+	};
 	vector<Fraction> f1;
 	Fraction max_checker; // максимальное значение для проверки
 						  // на однозначность
@@ -1768,24 +2095,18 @@ FiniteAutomaton::AmbiguityValue FiniteAutomaton::get_ambiguity_value(
 	vector<vector<char>> is_calculated(i);
 	int return_counter = 0;
 	for (int k = 0; true; k++) {
-		paths_number = 0;
-		min_paths_number = 0;
-		d[(k + 1) % 2] = vector<InfInt>(s);
-		min_d[(k + 1) % 2] = vector<InfInt>(min_s);
-		for (int v = 0; v < s; v++) {
-			for (int i = 0; i < s; i++) {
-				d[(k + 1) % 2][v] += InfInt(adjacency_matrix[i][v]) * d[k % 2][i];
-			}
-			if (fa.states[v].is_terminal)
-				paths_number += d[(k + 1) % 2][v];
-		}
-		for (int v = 0; v < min_s; v++) {
-			for (int i = 0; i < min_s; i++) {
-				min_d[(k + 1) % 2][v] += InfInt(min_adjacency_matrix[i][v]) * min_d[k % 2][i];
+		if (k == paths_numbers.size()) {
+			if (is_parallel) {
+				std::thread nfa_thread(count_batch, std::ref(counter), std::ref(paths_numbers));
+				count_batch(min_counter, min_paths_numbers);
+				nfa_thread.join();
+			} else {
+				count_batch(counter, paths_numbers);
+				count_batch(min_counter, min_paths_numbers);
 			}
-			if (min_fa.states[v].is_terminal)
-				min_paths_number += min_d[(k + 1) % 2][v];
 		}
+		paths_number = paths_numbers[k];
+		min_paths_number = min_paths_numbers[k];
 		Fraction new_f1_value;
 		if (min_paths_number == 0) {
 			new_f1_value = Fraction();
@@ -1833,10 +2154,15 @@ FiniteAutomaton::AmbiguityValue FiniteAutomaton::get_ambiguity_value(
 			}
 			calculated_check.emplace_back(f1_check.size());
 			is_calculated_check.emplace_back(f1_check.size(), 0);
-			Fraction val = calc_ambiguity(
-				new_s + i, new_s * new_s + delta, f1_check, calculated_check, is_calculated_check);
+			Fraction::Context context;
+			Fraction val = calc_ambiguity(new_s + i,
+										  new_s * new_s + delta,
+										  f1_check,
+										  calculated_check,
+										  is_calculated_check,
+										  context);
 			// limit check
-			if (Fraction::last_number_of_digits >= digits_number_limit ||
+			if (context.last_number_of_digits >= digits_number_limit ||
 				double(paths_number.numberOfDigits() + min_paths_number.numberOfDigits()) >=
 					double(digits_number_limit) / 2) {
 				word_length = k;
@@ -1878,9 +2204,197 @@ FiniteAutomaton::AmbiguityValue FiniteAutomaton::get_ambiguity_value(
 	return FiniteAutomaton::polynomially_ambigious;
 }
 
+vector<int> FiniteAutomaton::get_strongly_connected_components(const vector<vector<int>>& graph) {
+	int n = graph.size();
+	vector<int> component(n, -1), order(n, -1), lowlink(n), stack_states;
+	vector<bool> on_stack(n, false);
+	// стек обхода: вершина и номер следующего рассматриваемого ребра
+	vector<pair<int, int>> dfs;
+	int counter = 0, components_number = 0;
+	for (int root = 0; root < n; root++) {
+		if (order[root] != -1)
+			continue;
+		dfs.emplace_back(root, 0);
+		while (!dfs.empty()) {
+			auto& [v, edge] = dfs.back();
+			if (edge == 0 && order[v] == -1) {
+				order[v] = lowlink[v] = counter++;
+				stack_states.push_back(v);
+				on_stack[v] = true;
+			}
+			if (edge < graph[v].size()) {
+				int to = graph[v][edge++];
+				if (order[to] == -1)
+					dfs.emplace_back(to, 0);
+				else if (on_stack[to])
+					lowlink[v] = std::min(lowlink[v], order[to]);
+				continue;
+			}
+			int finished = v;
+			dfs.pop_back();
+			if (!dfs.empty())
+				lowlink[dfs.back().first] = std::min(lowlink[dfs.back().first], lowlink[finished]);
+			if (lowlink[finished] == order[finished]) {
+				int state;
+				do {
+					state = stack_states.back();
+					stack_states.pop_back();
+					on_stack[state] = false;
+					component[state] = components_number;
+				} while (state != finished);
+				components_number++;
+			}
+		}
+	}
+	return component;
+}
+
+FiniteAutomaton::AmbiguityValue FiniteAutomaton::get_structural_ambiguity_value() const {
+	FiniteAutomaton fa = remove_eps();
+	FATransitionTable table = fa.get_transition_table();
+	int n = fa.size();
+	int k = table.symbols_count();
+	if (n == 0)
+		return FiniteAutomaton::unambigious;
+
+	// полезные состояния: достижимые из начального и ведущие в финальное
+	vector<vector<int>> graph(n), reverse_graph(n);
+	for (int p = 0; p < n; p++)
+		for (int a = 0; a < k; a++)
+			for (int to : table.get_transitions(p, a)) {
+				graph[p].push_back(to);
+				reverse_graph[to].push_back(p);
+			}
+	auto get_reachable = [](const vector<vector<int>>& g, const vector<int>& sources) {
+		vector<bool> reachable(g.size(), false);
+		vector<int> queue;
+		for (int source : sources)
+			if (!reachable[source]) {
+				reachable[source] = true;
+				queue.push_back(source);
+			}
+		for (int i = 0; i < queue.size(); i++)
+			for (int to : g[queue[i]])
+				if (!reachable[to]) {
+					reachable[to] = true;
+					queue.push_back(to);
+				}
+		return reachable;
+	};
+	vector<int> final_states, final_pairs;
+	for (int p = 0; p < n; p++)
+		if (fa.states[p].is_terminal)
+			final_states.push_back(p);
+	vector<bool> accessible = get_reachable(graph, {fa.initial_state});
+	vector<bool> coaccessible = get_reachable(reverse_graph, final_states);
+	vector<bool> useful(n);
+	for (int p = 0; p < n; p++)
+		useful[p] = accessible[p] && coaccessible[p];
+	if (!useful[fa.initial_state])
+		return FiniteAutomaton::unambigious;
+
+	// квадрат автомата на парах полезных состояний, пара (p, q) имеет номер p * n + q
+	vector<vector<int>> square(n * n), reverse_square(n * n);
+	for (int p = 0; p < n; p++)
+		for (int q = 0; q < n; q++) {
+			if (!useful[p] || !useful[q])
+				continue;
+			for (int a = 0; a < k; a++)
+				for (int x : table.get_transitions(p, a))
+					for (int y : table.get_transitions(q, a))
+						if (useful[x] && useful[y]) {
+							square[p * n + q].push_back(x * n + y);
+							reverse_square[x * n + y].push_back(p * n + q);
+						}
+		}
+	for (int p : final_states)
+		for (int q : final_states)
+			final_pairs.push_back(p * n + q);
+
+	// однозначность: нет пары различных состояний на двух принимающих путях одного слова
+	vector<bool> square_accessible =
+		get_reachable(square, {fa.initial_state * n + fa.initial_state});
+	vector<bool> square_coaccessible = get_reachable(reverse_square, final_pairs);
+	bool is_unambiguous = true;
+	for (int p = 0; p < n && is_unambiguous; p++)
+		for (int q = 0; q < n; q++)
+			if (p != q && square_accessible[p * n + q] && square_coaccessible[p * n + q]) {
+				is_unambiguous = false;
+				break;
+			}
+	if (is_unambiguous)
+		return FiniteAutomaton::unambigious;
+
+	// EDA: компонента квадрата, содержащая и диагональную пару (p, p), и пару (q, q'), q != q'
+	vector<int> square_components = get_strongly_connected_components(square);
+	vector<bool> has_diagonal(n * n, false), has_off_diagonal(n * n, false);
+	for (int p = 0; p < n; p++)
+		for (int q = 0; q < n; q++)
+			if (useful[p] && useful[q])
+				(p == q ? has_diagonal : has_off_diagonal)[square_components[p * n + q]] = true;
+	for (int c = 0; c < n * n; c++)
+		if (has_diagonal[c] && has_off_diagonal[c])
+			return FiniteAutomaton::exponentially_ambiguous;
+
+	// IDA: p != q и слово v, для которого есть пути p -v-> p, p -v-> q, q -v-> q, т.е. путь
+	// в кубе автомата из (p, p, q) в (p, q, q); первая компонента пути не покидает
+	// компоненту связности p, третья - компоненту q
+	vector<int> components = get_strongly_connected_components(graph);
+	vector<bool> on_cycle(n, false);
+	for (int p = 0; p < n; p++)
+		for (int to : graph[p])
+			if (components[to] == components[p])
+				on_cycle[p] = true;
+	vector<bool> reachable_from_p;
+	std::unordered_set<long long> visited;
+	vector<tuple<int, int, int>> queue;
+	for (int p = 0; p < n; p++) {
+		if (!useful[p] || !on_cycle[p])
+			continue;
+		reachable_from_p = get_reachable(graph, {p});
+		for (int q = 0; q < n; q++) {
+			if (q == p || !useful[q] || !on_cycle[q] || !reachable_from_p[q])
+				continue;
+			auto id = [n](int x, int y, int z) {
+				return (static_cast<long long>(x) * n + y) * n + z;
+			};
+			visited.clear();
+			queue.clear();
+			queue.emplace_back(p, p, q);
+			visited.insert(id(p, p, q));
+			for (int i = 0; i < queue.size(); i++) {
+				auto [x, y, z] = queue[i];
+				if (x == p && y == q && z == q)
+					return FiniteAutomaton::polynomially_ambigious;
+				for (int a = 0; a < k; a++)
+					for (int x1 : table.get_transitions(x, a)) {
+						if (components[x1] != components[p])
+							continue;
+						for (int y1 : table.get_transitions(y, a)) {
+							if (!useful[y1])
+								continue;
+							for (int z1 : table.get_transitions(z, a))
+								if (components[z1] == components[q] &&
+									visited.insert(id(x1, y1, z1)).second)
+									queue.emplace_back(x1, y1, z1);
+						}
+					}
+			}
+		}
+	}
+	return FiniteAutomaton::almost_unambigious;
+}
+
 FiniteAutomaton::AmbiguityValue FiniteAutomaton::ambiguity(iLogTemplate* log) const {
+	return ambiguity(AmbiguityMode::path_counting, log);
+}
+
+FiniteAutomaton::AmbiguityValue FiniteAutomaton::ambiguity(AmbiguityMode mode,
+														   iLogTemplate* log) const {
 	std::optional<int> word_length;
-	FiniteAutomaton::AmbiguityValue result = get_ambiguity_value(300, word_length);
+	FiniteAutomaton::AmbiguityValue result = mode == AmbiguityMode::structural
+												 ? get_structural_ambiguity_value()
+												 : get_ambiguity_value(300, word_length);
 	if (log) {
 		log->set_parameter("oldautomaton", *this);
 		if (word_length.has_value()) {
@@ -2186,23 +2700,25 @@ bool FiniteAutomaton::semdet_entry(bool annoted, iLogTemplate* log) const {
 	}
 	vector<Regex> state_languages;
 	state_languages.resize(states.size());
+	// Получение языка из производной регулярки автомата по префиксу:
+	//		this -> reg (arden?)
+	// регулярка общая для всех состояний, производные по общим началам префиксов запоминаются
+	Regex reg = to_regex();
+	RegexDerivatives derivatives;
+	int reg_id = derivatives.add(reg);
 	for (int i = 0; i < states.size(); i++) {
 		auto prefix = get_prefix(initial_state, i, was);
 		was.clear();
 		// cout << "Try " << i << "\n";
 		if (!prefix.has_value())
 			continue;
-		Regex reg;
-		// Получение языка из производной регулярки автомата по префиксу:
-		//		this -> reg (arden?)
-		reg = to_regex();
 		//  cout << "State: " << i << "\n";
 		//  cout << "Prefix: " << prefix.value() << "\n";
 		//  cout << "Regex: " << reg.to_txt() << "\n";
-		auto derivative = reg.prefix_derivative(prefix.value());
-		if (!derivative.has_value())
+		int derivative = derivatives.prefix_derivative(reg_id, prefix.value());
+		if (derivative == derivatives.empty_set())
 			continue;
-		state_languages[i] = derivative.value();
+		state_languages[i] = derivatives.to_regex(derivative);
 		// cout << "Derevative: " << state_languages[i].to_txt() << "\n";
 
 		// TODO: logs
@@ -2286,66 +2802,56 @@ bool FiniteAutomaton::semdet(iLogTemplate* log) const {
 // }
 
 pair<int, bool> FiniteAutomaton::parse(const string& s) const {
-	struct ParingState {
-		int pos;
-		const FAState* state;
-
-		ParingState(int pos, const FAState* state) : pos(pos), state(state) {}
-	};
-	// Пара (актуальный индекс элемента в строке, состояние)
-	stack<ParingState> stack_state;
-	// Тройка (актуальный индекс элемента в строке, начало эпсилон-перехода, конец эпсилон-перехода)
-	set<tuple<int, int, int>> visited_eps;
+	// моделирование НКА по Томпсону: на каждой позиции строки хранится множество активных
+	// состояний, замкнутое по eps-переходам; каждое состояние активируется не более одного раза
+	// на позицию, поэтому разбор занимает O(|s| * (|Q| + |переходов|))
+	FATransitionTable table = get_transition_table();
+	std::optional<FATransitionTable::Index> epsilon = table.get_epsilon();
+	// счётчик шагов - число рассмотренных пар (позиция в строке, состояние)
 	int counter = 0;
-	int parsed_len = 0;
-	const FAState* state = &states[initial_state];
-	stack_state.emplace(parsed_len, state);
-	while (!stack_state.empty()) {
-		if (state->is_terminal && parsed_len == s.size()) {
-			break;
-		}
-		state = stack_state.top().state;
-		parsed_len = stack_state.top().pos;
-		stack_state.pop();
-		counter++;
-		Symbol symb(s[parsed_len]);
-		set<int> trans;
-		if (state->transitions.count(symb))
-			trans = state->transitions.at(symb);
-		// Переходы в новые состояния по очередному символу строки
-		if (parsed_len + 1 <= s.size()) {
-			for (int to : trans) {
-				stack_state.emplace(parsed_len + 1, &states[to]);
-			}
-		}
+	vector<int> active, next_active;
+	vector<bool> is_active(states.size(), false), is_next_active(states.size(), false);
+	auto activate = [&](int state, vector<int>& set_states, vector<bool>& in_set) {
+		if (in_set[state])
+			return;
+		in_set[state] = true;
+		size_t closed = set_states.size();
+		set_states.push_back(state);
+		if (!epsilon)
+			return;
+		// добавленные состояния дозамыкаются по eps-переходам в порядке добавления
+		for (; closed < set_states.size(); closed++)
+			for (int eps_to : table.get_transitions(set_states[closed], *epsilon))
+				if (!in_set[eps_to]) {
+					in_set[eps_to] = true;
+					set_states.push_back(eps_to);
+				}
+	};
 
-		// Если произошёл откат по строке, то эпсилон-переходы из рассмотренных состояний больше не
-		// считаются повторными
-		if (!visited_eps.empty()) {
-			set<tuple<int, int, int>> temp_eps;
-			for (auto pos : visited_eps) {
-				if (std::get<0>(pos) <= parsed_len)
-					temp_eps.insert(pos);
-			}
-			visited_eps = temp_eps;
-		}
-		// Добавление тех эпсилон-переходов, по которым ещё не было разбора от этой позиции и этого
-		// состояния
-		set<int> reach_eps;
-		if (state->transitions.count(Symbol::Epsilon))
-			reach_eps = state->transitions.at(Symbol::Epsilon);
-		for (int eps_to : reach_eps) {
-			if (!visited_eps.count({parsed_len, state->index, eps_to})) {
-				stack_state.emplace(parsed_len, &states[eps_to]);
-				visited_eps.insert({parsed_len, state->index, eps_to});
-			}
+	activate(initial_state, active, is_active);
+	for (char c : s) {
+		std::optional<FATransitionTable::Index> symbol = table.find_symbol(c);
+		counter += active.size();
+		if (!symbol) {
+			active.clear();
+			break;
 		}
+		for (int state : active)
+			for (int to : table.get_transitions(state, *symbol))
+				activate(to, next_active, is_next_active);
+		for (int state : active)
+			is_active[state] = false;
+		active.swap(next_active);
+		is_active.swap(is_next_active);
+		next_active.clear();
+		if (active.empty())
+			break;
 	}
+	counter += active.size();
 
-	if (s.size() == parsed_len && state->is_terminal) {
-		return {counter, true};
-	}
-
+	for (int state : active)
+		if (states[state].is_terminal)
+			return {counter, true};
 	return {counter, false};
 }
 
@@ -2461,7 +2967,10 @@ Regex FiniteAutomaton::to_regex(iLogTemplate* log) const {
 	}
 
 	// a system of linear algebraic equations
-	std::unordered_map<int, std::unordered_map<int, Regex>> SLAE{};
+	// коэффициенты - номера выражений в DAG: подстановки разделяют общие подвыражения
+	// вместо их копирования, дерево строится один раз для ответа
+	RegexDAG dag;
+	std::unordered_map<int, std::unordered_map<int, int>> SLAE{};
 	// индекс стартового состояния (должен быть среди состояний)
 	const int start_state_index = initial_state;
 	// индекс глобального конечного состояния (должен не быть среди состояний)
@@ -2479,26 +2988,23 @@ Regex FiniteAutomaton::to_regex(iLogTemplate* log) const {
 
 	// заполнение уравнений системы актуальными значениями
 	for (const auto& state : states) {
-		SLAE.insert({state.index, std::unordered_map<int, Regex>{}});
+		SLAE.insert({state.index, std::unordered_map<int, int>{}});
 
 		// если завершающее состояние, добавляем eps-переход
 		if (state.is_terminal) {
-			SLAE[state.index].insert({end_state_index, Regex{}});
+			SLAE[state.index].insert({end_state_index, dag.eps()});
 		}
 
 		// итерируемся по всем путям из state
 		for (const auto& [symbol, states_to] : state.transitions) {
 
 			// распознание eps-перехода
-			Regex symbol_regex{};
-			if (!symbol.is_epsilon()) {
-				symbol_regex = Regex(symbol);
-			}
+			int symbol_regex = symbol.is_epsilon() ? dag.eps() : dag.add(Regex(symbol));
 
 			for (int state_index_to : states_to) {
 				if (SLAE[state.index].count(state_index_to)) {
 					SLAE[state.index][state_index_to] =
-						Regex(Regex::Type::alt, &SLAE[state.index][state_index_to], &symbol_regex);
+						dag.alt(SLAE[state.index][state_index_to], symbol_regex);
 				} else {
 					SLAE[state.index].insert({state_index_to, symbol_regex});
 				}
@@ -2507,7 +3013,7 @@ Regex FiniteAutomaton::to_regex(iLogTemplate* log) const {
 	}
 
 	// теорема Ардена о переходах в себя
-	auto arden_theorem = [&SLAE](int state_index) {
+	auto arden_theorem = [&SLAE, &dag](int state_index) {
 		// передан индекс несуществующего состояния
 		if (!SLAE.count(state_index)) {
 			return;
@@ -2519,11 +3025,11 @@ Regex FiniteAutomaton::to_regex(iLogTemplate* log) const {
 		}
 
 		// подготавливаем звёздную регулярку
-		Regex state_self_regex(Regex::Type::star, &SLAE[state_index][state_index]);
+		int state_self_regex = dag.star(SLAE[state_index][state_index]);
 
 		// добавление звёздного перехода к остальным переходам уравнения
 		for (auto& [state_index_to, to_regex] : SLAE[state_index]) {
-			to_regex = Regex(Regex::Type::conc, &state_self_regex, &to_regex);
+			to_regex = dag.conc(state_self_regex, to_regex);
 		}
 
 		// удаление рассмотренного перехода состояния в себя же
@@ -2555,13 +3061,12 @@ Regex FiniteAutomaton::to_regex(iLogTemplate* log) const {
 			// итерация по всем переходам из исходного уравнения
 			for (auto& [state_index_col, regex_col] : equation_row) {
 				// регулярка перехода из рассматриваемого уравнения в исходное
-				Regex regex_from =
-					Regex(Regex::Type::conc, &equation_from[state_index_row], &regex_col);
+				int regex_from = dag.conc(equation_from[state_index_row], regex_col);
 
 				// объединяем полученную регулярку с имеющейся в рассматриваемом уравнении
 				if (equation_from.count(state_index_col)) {
 					equation_from[state_index_col] =
-						Regex(Regex::Type::alt, &equation_from[state_index_col], &regex_from);
+						dag.alt(equation_from[state_index_col], regex_from);
 				} else {
 					equation_from.insert({state_index_col, regex_from});
 				}
@@ -2580,7 +3085,7 @@ Regex FiniteAutomaton::to_regex(iLogTemplate* log) const {
 
 	// возвращаем путь из начало в конец
 	if (SLAE.count(start_state_index) && SLAE[start_state_index].count(end_state_index)) {
-		auto& result_regex = SLAE[start_state_index][end_state_index];
+		Regex result_regex = dag.to_regex(SLAE[start_state_index][end_state_index]);
 
 		// подстановка нужного языка в финальную регулярку
 		result_regex.set_language(language);
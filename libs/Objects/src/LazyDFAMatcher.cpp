@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <utility>
+
+#include "Objects/FiniteAutomaton.h"
+#include "Objects/LazyDFAMatcher.h"
+
+using std::string_view;
+using std::vector;
+
+LazyDFAMatcher::LazyDFAMatcher(const FiniteAutomaton& fa, size_t memory_limit)
+	: table(fa.get_transition_table()), closures(table), memory_limit(memory_limit) {
+	for (const FAState& state : fa.states)
+		is_terminal.push_back(state.is_terminal);
+	is_productive = table.get_productive(is_terminal);
+	for (int c = 0; c < 256; c++)
+		byte_symbol[c] = table.find_symbol(static_cast<char>(c));
+	symbols_number = table.symbols_count();
+	if (!fa.states.empty())
+		initial_subset = closures.get_closure(vector<int>{fa.initial_state});
+}
+
+void LazyDFAMatcher::flush() {
+	index_by_subset.clear();
+	subset_by_index.clear();
+	is_accepting.clear();
+	is_live.clear();
+	next.clear();
+	memory_used = 0;
+	initial_index = unknown;
+	flushes_number++;
+}
+
+int LazyDFAMatcher::add_state(vector<int>&& subset) {
+	// грубая оценка: ключ и узел хэш-таблицы, строка переходов, служебные поля
+	size_t state_memory =
+		subset.size() * sizeof(int) + symbols_number * sizeof(int) + 8 * sizeof(void*);
+	// сбрасываем кэш, но не ради единственного состояния, иначе разбор не продвинется
+	if (memory_used + state_memory > memory_limit && !subset_by_index.empty())
+		flush();
+	memory_used += state_memory;
+
+	int index = subset_by_index.size();
+	bool accepting = std::any_of(
+		subset.begin(), subset.end(), [this](int state) { return is_terminal[state]; });
+	// из мёртвого подмножества финальные состояния недостижимы
+	bool live = std::any_of(
+		subset.begin(), subset.end(), [this](int state) { return is_productive[state]; });
+	auto it = index_by_subset.emplace(std::move(subset), index).first;
+	subset_by_index.push_back(&it->first);
+	is_accepting.push_back(accepting);
+	is_live.push_back(live);
+	next.resize(next.size() + symbols_number, unknown);
+	return index;
+}
+
+int LazyDFAMatcher::get_next(int state, FATransitionTable::Index symbol) {
+	vector<int> targets;
+	for (int from : *subset_by_index[state])
+		for (int to : table.get_transitions(from, symbol))
+			targets.push_back(to);
+	vector<int> subset = closures.get_closure(targets);
+
+	auto it = index_by_subset.find(subset);
+	if (it != index_by_subset.end())
+		return next[state * symbols_number + symbol] = it->second;
+	size_t cached_before = subset_by_index.size();
+	int index = add_state(std::move(subset));
+	// после сброса кэша состояния state в нём больше нет
+	if (subset_by_index.size() > cached_before)
+		next[state * symbols_number + symbol] = index;
+	return index;
+}
+
+void LazyDFAMatcher::reset() {
+	consumed = 0;
+	current = unknown;
+	if (initial_subset.empty())
+		return;
+	if (initial_index == unknown)
+		initial_index = add_state(vector<int>(initial_subset));
+	current = is_live[initial_index] ? initial_index : unknown;
+}
+
+bool LazyDFAMatcher::feed(string_view chunk) {
+	if (current == unknown)
+		return false;
+	for (size_t i = 0; i < chunk.size(); i++) {
+		auto symbol = byte_symbol[static_cast<unsigned char>(chunk[i])];
+		if (symbol) {
+			int to = next[current * symbols_number + *symbol];
+			current = to == unknown ? get_next(current, *symbol) : to;
+		}
+		if (!symbol || !is_live[current]) {
+			current = unknown;
+			consumed += i + 1;
+			return false;
+		}
+	}
+	consumed += chunk.size();
+	return true;
+}
+
+bool LazyDFAMatcher::finish() const {
+	return current != unknown && is_accepting[current];
+}
+
+bool LazyDFAMatcher::match(string_view word) {
+	reset();
+	feed(word);
+	return finish();
+}
+
+vector<bool> LazyDFAMatcher::match(const vector<string_view>& words) {
+	vector<bool> result(words.size());
+	for (int i = 0; i < words.size(); i++)
+		result[i] = match(words[i]);
+	return result;
+}
+
+size_t LazyDFAMatcher::cached_states_count() const {
+	return subset_by_index.size();
+}
+
+size_t LazyDFAMatcher::flushes_count() const {
+	return flushes_number;
+}
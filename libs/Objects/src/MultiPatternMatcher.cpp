@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <utility>
+
+#include "Objects/FiniteAutomaton.h"
+#include "Objects/Language.h"
+#include "Objects/MultiPatternMatcher.h"
+#include "Objects/Regex.h"
+
+using std::string_view;
+using std::vector;
+
+MultiPatternMatcher::MultiPatternMatcher(const FiniteAutomaton& dfa, size_t patterns_number,
+										 vector<vector<int>> patterns_by_state)
+	: matcher(dfa), patterns_number(patterns_number),
+	  patterns_by_state(std::move(patterns_by_state)) {}
+
+MultiPatternMatcher::MultiPatternMatcher(const vector<FiniteAutomaton>& patterns)
+	: MultiPatternMatcher(compile(patterns)) {}
+
+MultiPatternMatcher::MultiPatternMatcher(const vector<Regex>& patterns)
+	: MultiPatternMatcher([&patterns]() {
+		  vector<FiniteAutomaton> automata;
+		  for (const Regex& pattern : patterns)
+			  automata.push_back(pattern.to_glushkov());
+		  return compile(automata);
+	  }()) {}
+
+MultiPatternMatcher MultiPatternMatcher::compile(const vector<FiniteAutomaton>& patterns) {
+	// объединение: состояние 0 - новое начальное, далее состояния шаблонов подряд;
+	// идентификаторы пустые, чтобы детерминизация не собирала длинные строки
+	vector<FAState> states;
+	states.emplace_back(0, "", false);
+	vector<int> pattern_of_state = {-1};
+	Alphabet alphabet;
+	for (int pattern = 0; pattern < patterns.size(); pattern++) {
+		const FiniteAutomaton& fa = patterns[pattern];
+		int offset = states.size();
+		states[0].transitions[Symbol::Epsilon].insert(fa.initial_state + offset);
+		for (const FAState& state : fa.states) {
+			FAState::Transitions transitions;
+			for (const auto& [symbol, symbol_transitions] : state.transitions)
+				for (int to : symbol_transitions)
+					transitions[symbol].insert(to + offset);
+			states.emplace_back(
+				state.index + offset, "", state.is_terminal, std::move(transitions));
+			pattern_of_state.push_back(pattern);
+		}
+		const Alphabet& pattern_alphabet = fa.language->get_alphabet();
+		alphabet.insert(pattern_alphabet.begin(), pattern_alphabet.end());
+	}
+
+	// метка состояния ДКА - его подмножество состояний объединения
+	FiniteAutomaton dfa = FiniteAutomaton(0, states, alphabet).determinize();
+	vector<vector<int>> patterns_by_state(dfa.states.size() + 1);
+	for (int i = 0; i < dfa.states.size(); i++) {
+		vector<int>& accepted = patterns_by_state[i];
+		for (int state : dfa.states[i].label)
+			if (states[state].is_terminal)
+				accepted.push_back(pattern_of_state[state]);
+		std::sort(accepted.begin(), accepted.end());
+		accepted.erase(std::unique(accepted.begin(), accepted.end()), accepted.end());
+	}
+	return MultiPatternMatcher(dfa, patterns.size(), std::move(patterns_by_state));
+}
+
+size_t MultiPatternMatcher::patterns_count() const {
+	return patterns_number;
+}
+
+size_t MultiPatternMatcher::states_count() const {
+	return matcher.states_count();
+}
+
+const vector<int>& MultiPatternMatcher::match(string_view word) const {
+	return patterns_by_state[matcher.run(word)];
+}
+
+vector<vector<int>> MultiPatternMatcher::match(const vector<string_view>& words) const {
+	vector<vector<int>> result;
+	result.reserve(words.size());
+	for (string_view word : words)
+		result.push_back(match(word));
+	return result;
+}
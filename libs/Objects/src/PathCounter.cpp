@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <limits>
+
+#include "Objects/FiniteAutomaton.h"
+#include "Objects/PathCounter.h"
+
+using std::vector;
+
+PathCounter::PathCounter(const FiniteAutomaton& fa) {
+	int n = fa.states.size();
+	edges_begin.push_back(0);
+	vector<uint64_t> multiplicity(n, 0);
+	vector<int> targets;
+	for (int i = 0; i < n; i++) {
+		targets.clear();
+		for (const auto& [symbol, symbol_transitions] : fa.states[i].transitions)
+			for (int to : symbol_transitions)
+				if (multiplicity[to]++ == 0)
+					targets.push_back(to);
+		for (int to : targets) {
+			edge_target.push_back(to);
+			edge_multiplicity.push_back(multiplicity[to]);
+			multiplicity[to] = 0;
+		}
+		edges_begin.push_back(edge_target.size());
+		is_terminal.push_back(fa.states[i].is_terminal);
+	}
+	counts.assign(n, 0);
+	next_counts.assign(n, 0);
+	if (n)
+		counts[fa.initial_state] = 1;
+}
+
+bool PathCounter::next_small(uint64_t& paths_number) {
+	const uint64_t max = std::numeric_limits<uint64_t>::max();
+	std::fill(next_counts.begin(), next_counts.end(), 0);
+	for (int i = 0; i < counts.size(); i++) {
+		if (!counts[i])
+			continue;
+		for (int e = edges_begin[i]; e < edges_begin[i + 1]; e++) {
+			uint64_t multiplicity = edge_multiplicity[e];
+			if (counts[i] > max / multiplicity)
+				return false;
+			uint64_t added = counts[i] * multiplicity;
+			uint64_t& count = next_counts[edge_target[e]];
+			if (count > max - added)
+				return false;
+			count += added;
+		}
+	}
+	paths_number = 0;
+	for (int v = 0; v < next_counts.size(); v++)
+		if (is_terminal[v]) {
+			if (paths_number > max - next_counts[v])
+				return false;
+			paths_number += next_counts[v];
+		}
+	counts.swap(next_counts);
+	return true;
+}
+
+InfInt PathCounter::next_big() {
+	for (auto& count : next_big_counts)
+		count = 0;
+	for (int i = 0; i < big_counts.size(); i++) {
+		if (big_counts[i] == 0)
+			continue;
+		for (int e = edges_begin[i]; e < edges_begin[i + 1]; e++) {
+			if (edge_multiplicity[e] == 1)
+				next_big_counts[edge_target[e]] += big_counts[i];
+			else
+				next_big_counts[edge_target[e]] +=
+					big_counts[i] * InfInt(static_cast<unsigned long long>(edge_multiplicity[e]));
+		}
+	}
+	InfInt paths_number;
+	for (int v = 0; v < next_big_counts.size(); v++)
+		if (is_terminal[v])
+			paths_number += next_big_counts[v];
+	big_counts.swap(next_big_counts);
+	return paths_number;
+}
+
+InfInt PathCounter::next() {
+	if (!is_big) {
+		uint64_t paths_number;
+		if (next_small(paths_number))
+			return InfInt(static_cast<unsigned long long>(paths_number));
+		// переполнение: шаг повторяется в длинной арифметике
+		is_big = true;
+		for (uint64_t count : counts)
+			big_counts.emplace_back(static_cast<unsigned long long>(count));
+		next_big_counts.resize(big_counts.size());
+		counts.clear();
+		next_counts.clear();
+	}
+	return next_big();
+}
+
+bool PathCounter::is_using_big_integers() const {
+	return is_big;
+}
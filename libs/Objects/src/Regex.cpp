@@ -1,7 +1,8 @@
-#include <unordered_set>
+#include <algorithm>
 
 #include "Objects/BackRefRegex.h"
 #include "Objects/Language.h"
+#include "Objects/RegexDerivatives.h"
 #include "Objects/iLogTemplate.h"
 
 using std::cerr;
@@ -17,9 +18,11 @@ using std::vector;
 
 Regex::Regex(const string& str) : Regex() {
 	try {
-		bool res = from_string(str);
+		size_t error_position;
+		bool res = from_string(str, error_position);
 		if (!res) {
-			throw std::runtime_error("Regex::from_string() ERROR");
+			throw std::runtime_error("Regex::from_string() ERROR: invalid regex \"" + str +
+									 "\" at position " + to_string(error_position));
 		}
 	} catch (const std::runtime_error& re) {
 		cerr << re.what() << "\n";
@@ -42,9 +45,16 @@ Regex& Regex::operator=(const Regex& other) {
 	return *this;
 }
 
+Regex& Regex::operator=(Regex&& other) noexcept {
+	if (this != &other) {
+		clear();
+		move_from(other);
+	}
+	return *this;
+}
+
 void Regex::copy(const AlgExpression* other) {
 	auto* tmp = cast(other);
-	alphabet = tmp->alphabet;
 	type = tmp->type;
 	symbol = tmp->symbol;
 	language = tmp->language;
@@ -96,218 +106,125 @@ template <typename T> vector<Regex*> Regex::cast(vector<T*> ptrs, bool not_null_
 	return regexPointers;
 }
 
-Regex* Regex::expr(const vector<AlgExpression::Lexeme>& lexemes, int index_start, int index_end) {
-	AlgExpression* p;
-	p = scan_symb(lexemes, index_start, index_end);
-	if (!p) {
-		p = scan_eps(lexemes, index_start, index_end);
-	}
-
-	if (!p) {
-		p = scan_alt(lexemes, index_start, index_end);
-	}
-	if (!p) {
-		p = scan_conc(lexemes, index_start, index_end);
-	}
-	if (!p) {
-		p = scan_star(lexemes, index_start, index_end);
-	}
-	if (!p) {
-		p = scan_minus(lexemes, index_start, index_end);
-	}
-	if (!p) {
-		p = scan_par(lexemes, index_start, index_end);
-	}
-
-	return cast(p, false);
-}
-
-Regex* Regex::scan_minus(const vector<AlgExpression::Lexeme>& lexemes, int index_start,
-						 int index_end) {
-	Regex* p = nullptr;
-
-	if (lexemes[index_start].type != Lexeme::Type::negative) {
-		return nullptr;
-	}
-
-	Regex* l = expr(lexemes, index_start + 1, index_end);
-	if (l == nullptr) {
-		delete l;
-		return nullptr;
-	}
-	p = make();
-	p->term_l = l;
-	p->type = negative;
-
-	p->alphabet = l->alphabet;
-	return p;
-}
-
 vector<FAState> Regex::_to_thompson(const Alphabet& root_alphabet) const {
-	vector<FAState> fa_states; // вектор состояний нового автомата
-	// для формирования поля transitions состояния автомата (структуры State)
-	FAState::Transitions state_transitions;
-	int offset; // сдвиг для старых индексов состояний в новом автомате
-	// список состояний и макс индекс состояния для левого автомата относительно операции
-	vector<FAState> fa_left;
-	// список состояний и макс индекс состояния для правого автомата относительно операции
-	vector<FAState> fa_right;
-	// автомат для отрицания, строится обычный томпсон и берется дополнение
-	FiniteAutomaton fa_negative;
-	vector<FAState> fa_negative_states;
-
-	switch (type) {
-	case Type::eps:
-		fa_states.emplace_back(0, false);
-		fa_states[0].set_transition(1, Symbol::Epsilon);
-		fa_states.emplace_back(1, true);
-		return fa_states;
-	case Type::symb:
-		fa_states.emplace_back(0, false);
-		fa_states.emplace_back(1, true);
-		fa_states[0].set_transition(1, symbol);
-		return fa_states;
-	case Type::alt: // |
-		fa_left = Regex::cast(term_l)->_to_thompson(root_alphabet);
-		fa_right = Regex::cast(term_r)->_to_thompson(root_alphabet);
-
-		fa_states.emplace_back(0, false);
-		fa_states.back().set_transition(1, Symbol::Epsilon);
-		fa_states.back().set_transition(int(fa_left.size()) + 1, Symbol::Epsilon);
-
-		for (const auto& state : fa_left) {
-			state_transitions = {};
-			for (const auto& [symb, states] : state.transitions) {
-				for (int transition_to : states) {
-					state_transitions[symb].insert(transition_to + 1);
-				}
-			}
-
-			if (state.is_terminal) {
-				state_transitions[Symbol::Epsilon] = {int(fa_left.size() + fa_right.size()) + 1};
-			}
-
-			fa_states.emplace_back(state.index + 1, false, state_transitions);
-		}
-
-		offset = fa_states.size();
-		for (const auto& state : fa_right) {
-			state_transitions = {};
-			for (const auto& [symb, states] : state.transitions) {
-				for (int transition_to : states) {
-					state_transitions[symb].insert(transition_to + offset);
-				}
-			}
-
-			if (state.is_terminal) {
-				state_transitions[Symbol::Epsilon] = {offset + int(fa_right.size())};
-			}
-
-			fa_states.emplace_back(state.index + offset, false, state_transitions);
-		}
-
-		fa_states.emplace_back(int(fa_left.size() + fa_right.size()) + 1, "q", true);
-		return fa_states;
-	case Type::conc: // .
-		fa_left = Regex::cast(term_l)->_to_thompson(root_alphabet);
-		fa_right = Regex::cast(term_r)->_to_thompson(root_alphabet);
-
-		for (const auto& state : fa_left) {
-			state_transitions = {};
-			for (const auto& [symb, states] : state.transitions) {
-				for (int transition_to : states) {
-					state_transitions[symb].insert(transition_to);
-				}
-			}
-
-			if (state.is_terminal) {
-				for (const auto& [symb, states] : fa_right[0].transitions) {
-					for (int transition_to : states) {
-						state_transitions[symb].insert(transition_to + fa_left.size() - 1);
-					}
-				}
-			}
-
-			fa_states.emplace_back(state.index, false, state_transitions);
+	// состояния фрагмента занимают отрезок [base, base + size): начальное - первое,
+	// финальное - последнее. Левый потомок ноды k имеет номер k + 1 в прямом обходе,
+	// поддерево отрицания строится отдельно и в обход не входит
+	vector<const Regex*> nodes;
+	vector<int> right;
+	vector<pair<const Regex*, int>> stack = {{this, -1}};
+	while (!stack.empty()) {
+		auto [node, parent] = stack.back();
+		stack.pop_back();
+		int index = static_cast<int>(nodes.size());
+		if (parent != -1 && nodes[parent]->term_r == node)
+			right[parent] = index;
+		nodes.push_back(node);
+		right.push_back(-1);
+		if (node->type == Type::negative)
+			continue;
+		if (node->term_r)
+			stack.emplace_back(static_cast<const Regex*>(node->term_r), index);
+		if (node->term_l)
+			stack.emplace_back(static_cast<const Regex*>(node->term_l), index);
+	}
+
+	// размеры фрагментов снизу вверх
+	vector<int> size(nodes.size(), 0);
+	// для отрицания строится обычный томпсон и берется дополнение
+	unordered_map<int, FiniteAutomaton> negatives;
+	for (int k = static_cast<int>(nodes.size()) - 1; k >= 0; k--) {
+		int l = k + 1, r = right[k];
+		switch (nodes[k]->type) {
+		case Type::eps:
+		case Type::symb:
+			size[k] = 2;
+			break;
+		case Type::alt: // |
+			size[k] = size[l] + size[r] + 2;
+			break;
+		case Type::conc: // . - финальное состояние левого фрагмента совпадает с начальным правого
+			size[k] = size[l] + size[r] - 1;
+			break;
+		case Type::star: // *
+			size[k] = size[l] + 2;
+			break;
+		case Type::negative: {
+			FiniteAutomaton fa_negative(
+				0, static_cast<const Regex*>(nodes[k]->term_l)->_to_thompson(root_alphabet),
+				root_alphabet);
+			fa_negative = fa_negative.minimize().complement();
+			// если автомат имеет начальное состояние не 0 то исправляем это
+			if (fa_negative.get_initial() != 0)
+				fa_negative.set_initial_state_to_zero();
+			size[k] = fa_negative.size() + 1;
+			negatives.emplace(k, std::move(fa_negative));
+			break;
 		}
-
-		offset = fa_states.size();
-		for (size_t i = 1; i < fa_right.size(); i++) {
-			const FAState& state = fa_right[i];
-			state_transitions = {};
-			for (const auto& [symb, states] : state.transitions) {
-				for (int transition_to : states) {
-					state_transitions[symb].insert(transition_to + offset - 1);
-				}
-			}
-
-			fa_states.emplace_back(state.index + offset - 1, state.is_terminal, state_transitions);
-		}
-
-		return fa_states;
-	case Type::star: // *
-		fa_left = Regex::cast(term_l)->_to_thompson(root_alphabet);
-
-		fa_states.emplace_back(0, false);
-		fa_states.back().set_transition(1, Symbol::Epsilon);
-		fa_states.back().set_transition(int(fa_left.size()) + 1, Symbol::Epsilon);
-
-		for (const auto& state : fa_left) {
-			state_transitions = {};
-			for (const auto& [symb, states] : state.transitions) {
-				for (int transition_to : states) {
-					state_transitions[symb].insert(transition_to + 1);
-				}
-			}
-
-			if (state.is_terminal) {
-				state_transitions[Symbol::Epsilon] = {1, int(fa_left.size()) + 1};
-			}
-
-			fa_states.emplace_back(state.index + 1, false, state_transitions);
+		default:
+			break;
 		}
+	}
 
-		fa_states.emplace_back(int(fa_left.size()) + 1, true);
-		return fa_states;
-	case Type::negative:
-		// строим автомат для отрицания
-		fa_negative_states = Regex::cast(term_l)->_to_thompson(root_alphabet);
-
-		fa_negative = FiniteAutomaton(0, fa_negative_states, root_alphabet);
-		fa_negative = fa_negative.minimize();
-		// берем дополнение автомата
-		fa_negative = fa_negative.complement();
-
-		// если автомат имеет начальное состояние не 0 то исправляем это
-		if (fa_negative.get_initial() != 0)
-			fa_negative.set_initial_state_to_zero();
-
-		// нумеруем состояния
-		for (auto& state : fa_negative.states) {
-			if (state.is_terminal) {
-				state.is_terminal = false;
-				state.set_transition(fa_negative.size(), Symbol::Epsilon);
+	// состояния записываются в общий буфер сверху вниз, смещения потомков - от начала ноды
+	vector<FAState> fa_states; // вектор состояний нового автомата
+	fa_states.reserve(size[0]);
+	for (int i = 0; i < size[0]; i++)
+		fa_states.emplace_back(i, false);
+	vector<int> base(nodes.size(), 0);
+	for (int k = 0; k < static_cast<int>(nodes.size()); k++) {
+		int b = base[k], l = k + 1, r = right[k];
+		switch (nodes[k]->type) {
+		case Type::eps:
+			fa_states[b].set_transition(b + 1, Symbol::Epsilon);
+			break;
+		case Type::symb:
+			fa_states[b].set_transition(b + 1, nodes[k]->symbol);
+			break;
+		case Type::alt:
+			base[l] = b + 1;
+			base[r] = b + 1 + size[l];
+			fa_states[b].set_transition(base[l], Symbol::Epsilon);
+			fa_states[b].set_transition(base[r], Symbol::Epsilon);
+			fa_states[base[l] + size[l] - 1].set_transition(b + size[k] - 1, Symbol::Epsilon);
+			fa_states[base[r] + size[r] - 1].set_transition(b + size[k] - 1, Symbol::Epsilon);
+			break;
+		case Type::conc:
+			base[l] = b;
+			base[r] = b + size[l] - 1;
+			break;
+		case Type::star:
+			base[l] = b + 1;
+			fa_states[b].set_transition(b + 1, Symbol::Epsilon);
+			fa_states[b].set_transition(b + size[k] - 1, Symbol::Epsilon);
+			fa_states[b + size[l]].set_transition(b + 1, Symbol::Epsilon);
+			fa_states[b + size[l]].set_transition(b + size[k] - 1, Symbol::Epsilon);
+			break;
+		case Type::negative:
+			for (const auto& state : negatives.at(k).states) {
+				for (const auto& [symb, states_to] : state.transitions)
+					for (int transition_to : states_to)
+						fa_states[b + state.index].set_transition(b + transition_to, symb);
+				if (state.is_terminal)
+					fa_states[b + state.index].set_transition(b + size[k] - 1, Symbol::Epsilon);
 			}
+			break;
+		default:
+			break;
 		}
-
-		fa_negative.states.emplace_back(int(fa_negative.size()), true);
-
-		// возвращаем состояния и макс индекс
-		return fa_negative.states;
-	default:
-		break;
 	}
-	return {};
+	fa_states.back().is_terminal = true;
+	return fa_states;
 }
 
 FiniteAutomaton Regex::to_thompson(iLogTemplate* log) const {
-	vector<FAState> res = _to_thompson(alphabet);
-	vector<FAState> states;
-	for (const auto& i : res) {
-		states.emplace_back(i.index, "q" + to_string(i.index), i.is_terminal, i.transitions);
-	}
+	// дополнение берётся по алфавиту языка, а не только по символам дерева
+	std::shared_ptr<Language> fa_language = get_or_make_language();
+	vector<FAState> states = _to_thompson(fa_language->get_alphabet());
+	for (auto& state : states)
+		state.identifier = "q" + to_string(state.index);
 
-	FiniteAutomaton fa(0, states, language);
+	FiniteAutomaton fa(0, std::move(states), fa_language);
 	if (log) {
 		log->set_parameter("oldregex", *this);
 		log->set_parameter("result", fa);
@@ -383,133 +300,163 @@ bool Regex::contains_eps() const {
 	}
 }
 
-unordered_map<int, vector<int>> Regex::get_follow() const {
-	unordered_map<int, vector<int>> l, r;
-	vector<AlgExpression*> first, last;
-	switch (type) {
-	case Type::alt:
-		l = cast(term_l)->get_follow();
-		r = cast(term_r)->get_follow();
-		for (const auto& i : r) {
-			l[i.first].insert(l[i.first].end(), i.second.begin(), i.second.end());
-		}
-
-		return l;
-	case Type::conc:
-		l = cast(term_l)->get_follow();
-		r = cast(term_r)->get_follow();
-		for (const auto& i : r) {
-			l[i.first].insert(l[i.first].end(), i.second.begin(), i.second.end());
+Regex::Positions Regex::get_positions() const {
+	// ноды в прямом порядке обхода: левый потомок ноды k имеет номер k + 1,
+	// листья-символы встречаются слева направо, как при линеаризации
+	vector<const Regex*> nodes;
+	vector<int> right, position;
+	Positions positions;
+	vector<pair<const Regex*, int>> stack = {{this, -1}};
+	while (!stack.empty()) {
+		auto [node, parent] = stack.back();
+		stack.pop_back();
+		int index = static_cast<int>(nodes.size());
+		if (parent != -1 && nodes[parent]->term_r == node)
+			right[parent] = index;
+		nodes.push_back(node);
+		right.push_back(-1);
+		position.push_back(-1);
+		if (node->type == Type::symb) {
+			position[index] = static_cast<int>(positions.symbols.size());
+			positions.symbols.push_back(node->symbol);
 		}
-
-		last = cast(term_l)->get_last_nodes();
-		first = cast(term_r)->get_first_nodes();
-		for (auto& i : last) {
-			for (auto& j : first) {
-				l[i->get_symbol().last_linearization_number()].push_back(
-					j->get_symbol().last_linearization_number());
+		if (node->term_r)
+			stack.emplace_back(static_cast<const Regex*>(node->term_r), index);
+		if (node->term_l)
+			stack.emplace_back(static_cast<const Regex*>(node->term_l), index);
+	}
+
+	// списки first/last хранятся деревьями склеек: элемент - позиция (при l == -1)
+	// или конкатенация двух списков, поэтому объединение стоит O(1)
+	struct Chain {
+		int position, l, r;
+	};
+	vector<Chain> chains;
+	auto join = [&chains](int l, int r) {
+		if (l == -1 || r == -1)
+			return l == -1 ? r : l;
+		chains.push_back({-1, l, r});
+		return static_cast<int>(chains.size()) - 1;
+	};
+	auto unfold = [&chains](int chain, vector<int>& result) { // NOLINT(runtime/references)
+		result.clear();
+		vector<int> stack;
+		if (chain != -1)
+			stack.push_back(chain);
+		while (!stack.empty()) {
+			const Chain& current = chains[stack.back()];
+			stack.pop_back();
+			if (current.l == -1) {
+				result.push_back(current.position);
+			} else {
+				stack.push_back(current.r);
+				stack.push_back(current.l);
 			}
 		}
-
-		return l;
-	case Type::star:
-		l = cast(term_l)->get_follow();
-		last = cast(term_l)->get_last_nodes();
-		first = cast(term_l)->get_first_nodes();
-		for (auto& i : last) {
-			for (auto& j : first) {
-				l[i->get_symbol().last_linearization_number()].push_back(
-					j->get_symbol().last_linearization_number());
-			}
+	};
+
+	positions.follow.resize(positions.symbols.size());
+	vector<int> from, to;
+	auto add_follow = [&](int last, int first) {
+		unfold(last, from);
+		unfold(first, to);
+		for (int i : from)
+			positions.follow[i].insert(positions.follow[i].end(), to.begin(), to.end());
+	};
+
+	vector<char> nullable(nodes.size(), false);
+	vector<int> first(nodes.size(), -1), last(nodes.size(), -1);
+	for (int k = static_cast<int>(nodes.size()) - 1; k >= 0; k--) {
+		int l = k + 1, r = right[k];
+		switch (nodes[k]->type) {
+		case Type::eps:
+			nullable[k] = true;
+			break;
+		case Type::symb:
+			chains.push_back({position[k], -1, -1});
+			first[k] = last[k] = static_cast<int>(chains.size()) - 1;
+			break;
+		case Type::alt:
+			nullable[k] = nullable[l] || nullable[r];
+			first[k] = join(first[l], first[r]);
+			last[k] = join(last[l], last[r]);
+			break;
+		case Type::conc:
+			nullable[k] = nullable[l] && nullable[r];
+			first[k] = nullable[l] ? join(first[l], first[r]) : first[l];
+			last[k] = nullable[r] ? join(last[r], last[l]) : last[r];
+			add_follow(last[l], first[r]);
+			break;
+		case Type::star:
+			nullable[k] = true;
+			first[k] = first[l];
+			last[k] = last[l];
+			add_follow(last[l], first[l]);
+			break;
+		case Type::negative:
+			nullable[k] = !nullable[l];
+			break;
+		default:
+			break;
 		}
+	}
 
-		return l;
-	default:
-		return {};
+	// вложенные итерации ((a*b*)*) порождают одинаковые пары
+	for (auto& following : positions.follow) {
+		std::sort(following.begin(), following.end());
+		following.erase(std::unique(following.begin(), following.end()), following.end());
 	}
+	unfold(first[0], positions.first);
+	unfold(last[0], positions.last);
+	positions.nullable = nullable[0];
+	return positions;
 }
 
 FiniteAutomaton Regex::to_glushkov(iLogTemplate* log) const {
-	Regex temp_copy(*this);
-	vector<Regex*> terms = temp_copy.preorder_traversal();
-	for (size_t i = 0; i < terms.size(); i++) {
-		terms[i]->symbol.linearize(static_cast<int>(i));
-	}
-
-	vector<AlgExpression*> first = temp_copy.get_first_nodes(); // Множество начальных состояний
-	vector<AlgExpression*> last = temp_copy.get_last_nodes(); // Множество конечных состояний
-	// множество состояний, которым предшествует символ (ключ - линеаризованный номер)
-	unordered_map<int, vector<int>> following_states = temp_copy.get_follow();
-	int eps_in = this->contains_eps();
-	vector<FAState> states; // состояния автомата
-
-	string str_first, str_last, str_follow;
-	for (auto& i : first) {
-		str_first += string(i->get_symbol()) + "\\ ";
-	}
-
-	set<string> last_set;
-	for (auto& i : last) {
-		last_set.insert(string(i->get_symbol()));
-	}
-	for (const auto& elem : last_set) {
-		str_last += elem + "\\ ";
-	}
-	if (eps_in) {
-		str_last += Symbol::Epsilon;
-	}
-
-	for (const auto& i : following_states) {
-		for (auto& to : i.second) {
-			str_follow += "(" + string(terms[i.first]->symbol) + "," + string(terms[to]->symbol) +
-						  ")" + "\\ ";
-		}
-	}
-
-	// cout << temp_copy.to_str_log() << endl;
-	// cout << "First " << str_first << endl;
-	// cout << "End " << str_last << endl;
-	// cout << "Pairs " << str_follow << endl;
-
-	vector<Symbol> delinearized_symbols;
-	for (int i = 0; i < terms.size(); i++) {
-		delinearized_symbols.push_back(terms[i]->symbol);
-		delinearized_symbols[i].delinearize();
-	}
+	Positions positions = get_positions();
+	// имена состояний - линеаризованные символы
+	vector<Symbol> linearized_symbols = positions.symbols;
+	for (size_t i = 0; i < linearized_symbols.size(); i++)
+		linearized_symbols[i].linearize(static_cast<int>(i));
 
 	FAState::Transitions start_state_transitions;
-	for (auto& i : first) {
-		start_state_transitions[delinearized_symbols[i->get_symbol().last_linearization_number()]]
-			.insert(i->get_symbol().last_linearization_number() + 1);
-	}
-
-	if (eps_in) {
-		states.emplace_back(0, "S", true, start_state_transitions);
-	} else {
-		states.emplace_back(0, "S", false, start_state_transitions);
-	}
-
-	std::unordered_set<int> last_terms;
-	for (auto& i : last) {
-		last_terms.insert(i->get_symbol().last_linearization_number());
-	}
+	for (int i : positions.first)
+		start_state_transitions[positions.symbols[i]].insert(i + 1);
 
-	for (size_t i = 0; i < terms.size(); i++) {
-		Symbol& symb = terms[i]->symbol;
+	vector<FAState> states; // состояния автомата
+	states.emplace_back(0, "S", positions.nullable, start_state_transitions);
+	vector<char> is_last(positions.symbols.size(), false);
+	for (int i : positions.last)
+		is_last[i] = true;
+	for (size_t i = 0; i < positions.symbols.size(); i++) {
 		FAState::Transitions transitions;
-
-		for (int to : following_states[symb.last_linearization_number()]) {
-			transitions[delinearized_symbols[to]].insert(to + 1);
-		}
-
-		// В last_terms номера конечных лексем => last_terms.count проверяет есть ли
-		// номер лексемы в списке конечных лексем (является ли состояние конечным)
-		states.emplace_back(
-			i + 1, symb, last_terms.count(symb.last_linearization_number()), transitions);
+		for (int to : positions.follow[i])
+			transitions[positions.symbols[to]].insert(to + 1);
+		states.emplace_back(i + 1, linearized_symbols[i], is_last[i], std::move(transitions));
 	}
 
-	FiniteAutomaton fa(0, states, language);
+	FiniteAutomaton fa(0, states, get_or_make_language());
 	if (log) {
+		string str_first, str_last, str_follow;
+		for (int i : positions.first)
+			str_first += string(linearized_symbols[i]) + "\\ ";
+		set<string> last_set;
+		for (int i : positions.last)
+			last_set.insert(string(linearized_symbols[i]));
+		for (const auto& elem : last_set)
+			str_last += elem + "\\ ";
+		if (positions.nullable)
+			str_last += Symbol::Epsilon;
+		for (size_t i = 0; i < positions.follow.size(); i++)
+			for (int to : positions.follow[i])
+				str_follow += "(" + string(linearized_symbols[i]) + "," +
+							  string(linearized_symbols[to]) + ")" + "\\ ";
+
+		Regex temp_copy(*this);
+		vector<Regex*> terms = temp_copy.preorder_traversal();
+		for (size_t i = 0; i < terms.size(); i++)
+			terms[i]->symbol.linearize(static_cast<int>(i));
+
 		log->set_parameter("oldregex", *this);
 		log->set_parameter("linearised regex", temp_copy);
 		log->set_parameter("first", str_first);
@@ -522,74 +469,40 @@ FiniteAutomaton Regex::to_glushkov(iLogTemplate* log) const {
 
 FiniteAutomaton Regex::to_ilieyu(iLogTemplate* log) const {
 	FiniteAutomaton glushkov = this->to_glushkov();
-	vector<FAState> states = glushkov.states;
-	vector<int> follow;
-	for (size_t i = 0; i < states.size(); i++) {
-		FAState st1 = states[i];
-		FAState::Transitions map1 = st1.transitions;
-		for (size_t j = i + 1; j < states.size(); j++) {
-			FAState st2 = states[j];
-			FAState::Transitions map2 = st2.transitions;
-			bool flag = true;
-			if (i == j || map2.size() != map1.size() || st1.is_terminal != st2.is_terminal) {
-				continue;
-			}
-
-			for (auto& it1 : map1) {
-				set<int> v1 = it1.second;
-				set<int> v2 = map2[it1.first];
-				if (v1 != v2 /*equal(v1.begin(), v1.end(), v2.begin())*/) {
-					flag = false;
-					break;
-				}
-			}
-			if (flag) {
-				follow.push_back(j);
-				states[i].label.insert(j);
-			}
-		}
-	}
-
+	const vector<FAState>& states = glushkov.states;
+	// состояния с одинаковыми переходами и финальностью склеиваются в первое из них,
+	// в label представителя попадают номера склеенных с ним состояний
+	map<pair<bool, FAState::Transitions>, int> classes;
+	vector<int> class_index(states.size());
 	vector<FAState> new_states;
-	for (auto& state : states) {
-		if (find(follow.begin(), follow.end(), state.index) == follow.end()) {
-			new_states.push_back(state);
-		}
+	for (size_t i = 0; i < states.size(); i++) {
+		auto [it, inserted] = classes.emplace(
+			std::make_pair(states[i].is_terminal, states[i].transitions),
+			static_cast<int>(new_states.size()));
+		if (inserted)
+			new_states.push_back(states[i]);
+		else
+			new_states[it->second].label.insert(i);
+		class_index[i] = it->second;
 	}
 
 	string str_follow;
 	for (auto& new_state : new_states) {
-		int state_ind = new_state.index;
-		str_follow = str_follow + states[state_ind].identifier + ":\\ ";
-		for (auto j = states[state_ind].label.begin(); j != states[state_ind].label.end(); j++) {
-			str_follow = str_follow + states[*j].identifier + "\\ ";
-		}
+		str_follow = str_follow + new_state.identifier + ":\\ ";
+		for (int j : new_state.label)
+			str_follow = str_follow + states[j].identifier + "\\ ";
 		str_follow = str_follow + ";\\\\";
 	}
 
-	// cout << str_follow;
-
 	for (size_t i = 0; i < new_states.size(); i++) {
-		FAState v1 = new_states[i];
-		FAState::Transitions old_map = v1.transitions;
 		FAState::Transitions new_map;
-		for (auto& it1 : old_map) {
-			set<int> v1 = it1.second;
-			for (int transition_to : v1) {
-				for (size_t k = 0; k < new_states.size(); k++) {
-					if (new_states[k].label.find(transition_to) != new_states[k].label.end() ||
-						transition_to == new_states[k].index) {
-						new_map[it1.first].insert(k);
-					}
-				}
-			}
-		}
-		new_states[i].transitions = new_map;
-	}
-
-	for (size_t i = 0; i < new_states.size(); i++) {
+		for (const auto& [symbol, states_to] : new_states[i].transitions)
+			for (int transition_to : states_to)
+				new_map[symbol].insert(class_index[transition_to]);
+		new_states[i].transitions = std::move(new_map);
 		new_states[i].index = i;
 	}
+
 	FiniteAutomaton fa(0, new_states, glushkov.language);
 	if (log) {
 		log->set_parameter("oldregex", *this);
@@ -600,6 +513,117 @@ FiniteAutomaton Regex::to_ilieyu(iLogTemplate* log) const {
 	return fa;
 }
 
+FiniteAutomaton Regex::to_dfa(bool is_minimized, iLogTemplate* log) const {
+	std::shared_ptr<Language> dfa_language = get_or_make_language();
+	FiniteAutomaton dfa(0, {}, dfa_language);
+	if (is_minimized && dfa_language->is_min_dfa_cached()) {
+		dfa = dfa_language->get_min_dfa();
+		if (log) {
+			log->set_parameter("oldregex", *this);
+			log->set_parameter("result", dfa);
+		}
+		return dfa;
+	}
+
+
+	// состояния ДКА - битовые множества состояний автомата Глушкова:
+	// бит 0 - начальное состояние, бит p + 1 - позиция p
+	Positions positions = get_positions();
+	int positions_number = static_cast<int>(positions.symbols.size());
+	int words_number = (positions_number + 1 + 63) / 64;
+	vector<string> identifiers = {"S"};
+	vector<char> is_terminal = {positions.nullable};
+	for (int i = 0; i < positions_number; i++) {
+		Symbol linearized_symbol = positions.symbols[i];
+		linearized_symbol.linearize(i);
+		identifiers.push_back(linearized_symbol);
+		is_terminal.push_back(false);
+	}
+	for (int i : positions.last)
+		is_terminal[i + 1] = true;
+
+	// символы перебираются в порядке алфавита, как в determinize
+	vector<Symbol> symbols;
+	map<Symbol, int> symbol_index;
+	for (const Symbol& symb : dfa_language->get_alphabet()) {
+		symbol_index.emplace(symb, symbols.size());
+		symbols.push_back(symb);
+	}
+	vector<int> position_symbol;
+	for (const Symbol& symb : positions.symbols) {
+		auto [it, is_new] = symbol_index.emplace(symb, symbols.size());
+		if (is_new)
+			symbols.push_back(symb);
+		position_symbol.push_back(it->second);
+	}
+
+	vector<FAState>& states = dfa.states;
+	std::unordered_map<vector<uint64_t>, int, FASubsetHasher> index_by_subset;
+	vector<const vector<uint64_t>*> subset_by_index;
+	auto add_state = [&](const vector<uint64_t>& subset) {
+		if (auto it = index_by_subset.find(subset); it != index_by_subset.end())
+			return std::make_pair(it->second, false);
+		int index = static_cast<int>(states.size());
+		const vector<uint64_t>& key = index_by_subset.emplace(subset, index).first->first;
+		subset_by_index.push_back(&key);
+		set<int> label;
+		string identifier;
+		bool terminal = false;
+		for (int w = 0; w < words_number; w++)
+			for (int b = 0; b < 64 && key[w] >> b; b++)
+				if ((key[w] >> b) & 1) {
+					int i = w * 64 + b;
+					label.insert(label.end(), i);
+					if (!identifier.empty())
+						identifier += ", ";
+					identifier += identifiers[i];
+					terminal = terminal || is_terminal[i];
+				}
+		states.emplace_back(
+			index, std::move(label), std::move(identifier), terminal, FAState::Transitions());
+		return std::make_pair(index, true);
+	};
+
+	vector<uint64_t> subset(words_number, 0);
+	subset[0] = 1;
+	add_state(subset);
+	vector<vector<uint64_t>> next(symbols.size(), vector<uint64_t>(words_number));
+	vector<int> stack = {0};
+	while (!stack.empty()) {
+		int index = stack.back();
+		stack.pop_back();
+		for (auto& next_subset : next)
+			std::fill(next_subset.begin(), next_subset.end(), 0);
+		// переход в позицию помечен её символом, поэтому один проход по follow
+		// раскладывает переходы сразу по всем символам
+		const vector<uint64_t>& current = *subset_by_index[index];
+		for (int w = 0; w < words_number; w++)
+			for (int b = 0; b < 64 && current[w] >> b; b++)
+				if ((current[w] >> b) & 1) {
+					int i = w * 64 + b;
+					for (int to : i == 0 ? positions.first : positions.follow[i - 1])
+						next[position_symbol[to]][(to + 1) / 64] |= uint64_t(1) << ((to + 1) % 64);
+				}
+
+		for (size_t symbol = 0; symbol < symbols.size(); symbol++) {
+			auto [to, is_new] = add_state(next[symbol]);
+			if (is_new)
+				stack.push_back(to);
+			states[index].transitions[symbols[symbol]].insert(to);
+		}
+	}
+
+	if (is_minimized) {
+		dfa = dfa.merge_equivalent_classes(dfa.get_hopcroft_classes());
+		dfa_language->set_min_dfa(dfa);
+	}
+	if (log) {
+		log->set_parameter("oldregex", *this);
+		log->set_parameter("result", dfa);
+	}
+	return dfa;
+}
+
 void Regex::get_prefix(int len, set<string>& prefs) const {
 	set<string> prefs1, prefs2;
 	if (len == 0) {
@@ -661,106 +685,6 @@ void Regex::get_prefix(int len, set<string>& prefs) const {
 	}
 }
 
-bool Regex::derivative_with_respect_to_sym(Regex* respected_sym, const Regex* reg_e,
-										   Regex& result) const {
-	if (respected_sym->type != Type::eps && respected_sym->type != Type::symb) {
-		cout << "Invalid input: unexpected regex instead of symbol\n";
-		return false;
-	}
-	if (respected_sym->type == Type::eps) {
-		result = *reg_e;
-		return true;
-	}
-	Regex subresult, subresult1;
-	bool answer = true, answer1, answer2;
-	switch (reg_e->type) {
-	case Type::eps:
-		if (respected_sym->type != Type::eps)
-			return false;
-		result.type = Type::eps;
-		return answer;
-	case Type::symb:
-		if (respected_sym->symbol != reg_e->symbol) {
-			return false;
-		}
-		result.type = Type::eps;
-		return answer;
-	case Type::alt:
-		answer1 =
-			derivative_with_respect_to_sym(respected_sym, Regex::cast(reg_e->term_l), subresult);
-		answer2 =
-			derivative_with_respect_to_sym(respected_sym, Regex::cast(reg_e->term_r), subresult1);
-		if (answer1 && answer2) {
-			result.type = Type::alt;
-			result.term_l = subresult.make_copy();
-			result.term_r = subresult1.make_copy();
-			return true;
-		}
-		if (!answer1 && !answer2) {
-			return false;
-		}
-		if (answer1) {
-			result = subresult;
-			return true;
-		}
-		if (answer2 && !answer1) {
-			result = subresult1;
-			return true;
-		}
-		return answer;
-	case Type::conc:
-		subresult.type = Type::conc;
-		if (subresult.term_l == nullptr)
-			subresult.term_l = new Regex();
-		answer1 = derivative_with_respect_to_sym(
-			respected_sym, Regex::cast(reg_e->term_l), *Regex::cast(subresult.term_l));
-		subresult.term_r = reg_e->term_r->make_copy();
-		if (Regex::cast(reg_e->term_l)->contains_eps()) {
-			answer2 = derivative_with_respect_to_sym(
-				respected_sym, Regex::cast(reg_e->term_r), subresult1);
-			if (answer1 && answer2) {
-				result.type = Type::alt;
-				result.term_l = subresult.make_copy();
-				result.term_r = subresult1.make_copy();
-			}
-
-			if (answer1 && !answer2) {
-				result.type = subresult.type;
-				if (subresult.term_l != nullptr)
-					result.term_l = subresult.term_l->make_copy();
-				if (subresult.term_r != nullptr)
-					result.term_r = subresult.term_r->make_copy();
-			}
-
-			if (answer2 && !answer1) {
-				result.type = subresult1.type;
-				if (subresult1.term_l != nullptr)
-					result.term_l = subresult1.term_l->make_copy();
-				if (subresult1.term_r != nullptr)
-					result.term_r = subresult1.term_r->make_copy();
-			}
-
-			answer = answer1 | answer2;
-		} else {
-			answer = answer1;
-			result.type = subresult.type;
-			if (subresult.term_l != nullptr)
-				result.term_l = subresult.term_l->make_copy();
-			if (subresult.term_r != nullptr)
-				result.term_r = subresult.term_r->make_copy();
-		}
-		return answer;
-	case Type::star:
-		result.type = Type::conc;
-		if (result.term_l == nullptr)
-			result.term_l = new Regex();
-		bool answer = derivative_with_respect_to_sym(
-			respected_sym, Regex::cast(reg_e->term_l), *Regex::cast(result.term_l));
-		result.term_r = reg_e->make_copy();
-		return answer;
-	}
-}
-
 Regex* Regex::add_alt(std::vector<Regex> res, Regex* root) {
 	if (res.size() == 1) {
 		return res[0].make_copy();
@@ -907,36 +831,22 @@ bool Regex::partial_derivative_with_respect_to_sym(Regex* respected_sym, const R
 	}
 }
 
-bool Regex::derivative_with_respect_to_str(string str, const Regex* reg_e, Regex& result) const {
-	bool success = true;
-	Regex cur = *reg_e;
-	Regex next = *reg_e;
-	for (char i : str) {
-		Regex sym;
-		sym.type = Type::symb;
-		sym.symbol = i;
-		next.clear();
-		success &= derivative_with_respect_to_sym(&sym, &cur, next);
-		if (!success) {
-			return false;
-		}
-		cur = next;
-	}
-	result = next;
-	return success;
-}
-
 // Производная по символу
 std::optional<Regex> Regex::symbol_derivative(const Regex& respected_sym) const {
-	auto rs = respected_sym.make_copy();
-	Regex result;
-	std::optional<Regex> ans;
-	if (derivative_with_respect_to_sym(Regex::cast(rs), this, result))
-		ans = result;
-	else
-		ans = std::nullopt;
-	delete rs;
-	return ans;
+	if (respected_sym.type == Type::eps)
+		return *this;
+	if (respected_sym.type != Type::symb) {
+		cout << "Invalid input: unexpected regex instead of symbol\n";
+		return std::nullopt;
+	}
+	RegexDerivatives derivatives;
+	int derivative = derivatives.derivative(derivatives.add(*this), respected_sym.symbol);
+	if (derivative == derivatives.empty_set())
+		return std::nullopt;
+	Regex result = derivatives.to_regex(derivative);
+	// производная сохраняет алфавит исходного выражения
+	result.set_language(get_or_make_language()->get_alphabet());
+	return result;
 }
 
 void Regex::partial_symbol_derivative(const Regex& respected_sym, vector<Regex>& result) const {
@@ -946,13 +856,14 @@ void Regex::partial_symbol_derivative(const Regex& respected_sym, vector<Regex>&
 }
 
 std::optional<Regex> Regex::prefix_derivative(string respected_str) const {
-	Regex result;
-	std::optional<Regex> ans;
-	if (derivative_with_respect_to_str(respected_str, this, result))
-		ans = result;
-	else
-		ans = std::nullopt;
-	return ans;
+	RegexDerivatives derivatives;
+	int derivative = derivatives.prefix_derivative(derivatives.add(*this), respected_str);
+	if (derivative == derivatives.empty_set())
+		return std::nullopt;
+	Regex result = derivatives.to_regex(derivative);
+	// производная сохраняет алфавит исходного выражения
+	result.set_language(get_or_make_language()->get_alphabet());
+	return result;
 }
 
 int Regex::pump_length(iLogTemplate* log) const {
@@ -964,6 +875,9 @@ int Regex::pump_length(iLogTemplate* log) const {
 		return language->get_pump_length();
 	}
 	map<string, bool> checked_prefixes;
+	// производные по префиксам общие у всех разбиений префикса
+	RegexDerivatives derivatives;
+	int root = derivatives.add(*this);
 	for (int i = 1;; i++) {
 		set<string> prefs;
 		get_prefix(i, prefs);
@@ -984,6 +898,10 @@ int Regex::pump_length(iLogTemplate* log) const {
 			}
 			if (was)
 				continue;
+			int derivative = derivatives.prefix_derivative(root, *it);
+			if (derivative == derivatives.empty_set())
+				continue;
+			Regex rest = derivatives.to_regex(derivative);
 			for (int j = 0; j < it->size(); j++) {
 				for (int k = j + 1; k <= it->size(); k++) {
 					string pumped_prefix;
@@ -991,10 +909,7 @@ int Regex::pump_length(iLogTemplate* log) const {
 					pumped_prefix += "(" + it->substr(j, k - j) + ")*";
 					pumped_prefix += it->substr(k, it->size() - k + j);
 					Regex a(pumped_prefix);
-					Regex b;
-					Regex pumping(Type::conc, &a, &b);
-					if (!derivative_with_respect_to_str(*it, this, *Regex::cast(pumping.term_r)))
-						continue;
+					Regex pumping(Type::conc, &a, &rest);
 					pumping.make_language();
 					// cout << pumped_prefix << " " << pumping.term_r->to_txt();
 					if (subset(pumping)) {
@@ -1065,93 +980,98 @@ FiniteAutomaton Regex::to_antimirov(iLogTemplate* log) const {
 	// список состояний в итоговом автомате
 	// собирается в процессе работы алгоритма
 	vector<Regex> fa_states;
+	// номера состояний по записи производной: одинаково записанные производные совпадают
+	unordered_map<string, int> state_indexes;
+	vector<FAState::Transitions> transitions;
 	// список букв, по которым будут браться частные производные
-	vector<Regex> symbols;
-	// спсиок информации о производных {{regex, производная от r, сивол по которому
-	// дифференцировали}}
-	vector<vector<Regex>> partial_derivatives_by_regex;
-	// мнжество всех частных производных в строковом формате,
-	// чтобы не добавлять в fa_states повторяющиеся regex
-	std::unordered_set<string> check;
-	for (const Symbol& as : language->get_alphabet()) {
-		symbols.emplace_back(as);
+	vector<pair<Symbol, Regex>> symbols;
+	std::shared_ptr<Language> fa_language = get_or_make_language();
+	for (const Symbol& as : fa_language->get_alphabet()) {
+		symbols.emplace_back(as, Regex(as));
 	}
 
+	string deriv_log;
 	fa_states.push_back(*this);
-	check.insert(to_txt());
+	state_indexes.emplace(to_txt(), 0);
+	transitions.emplace_back();
 	for (size_t i = 0; i < fa_states.size(); i++) {
-		Regex regex_state = fa_states[i];
-		for (const auto& s : symbols) {
-			// список частных производных от fa_states[i] по символу s
+		for (const auto& [symb, symb_regex] : symbols) {
+			// список частных производных от fa_states[i] по символу symb
 			vector<Regex> regs_der;
-			regex_state.partial_symbol_derivative(s, regs_der);
-			for (const auto& reg_der : regs_der) {
-				partial_derivatives_by_regex.push_back({regex_state, reg_der, s});
-				size_t old_checks = check.size();
-				check.insert(reg_der.to_txt());
-				if (old_checks != check.size()) {
-					fa_states.push_back(reg_der);
+			fa_states[i].partial_symbol_derivative(symb_regex, regs_der);
+			for (auto& reg_der : regs_der) {
+				string reg_der_txt = reg_der.to_txt();
+				if (log) {
+					deriv_log += string(symb) + "(" + fa_states[i].to_txt() + ")" + "\\ =\\ " +
+								 (reg_der_txt.empty() ? "eps" : reg_der_txt) + "\\\\";
 				}
+
+				auto [it, inserted] = state_indexes.emplace(reg_der_txt, fa_states.size());
+				if (inserted) {
+					fa_states.push_back(std::move(reg_der));
+					transitions.emplace_back();
+				}
+				transitions[i][symb].insert(it->second);
 			}
 		}
 	}
 
-	vector<string> name_states;
-
-	for (auto& state : fa_states) {
-		name_states.push_back(state.to_txt());
-	}
-
 	vector<FAState> automat_state;
+	for (size_t i = 0; i < fa_states.size(); i++) {
+		string state = fa_states[i].to_txt();
+		bool is_terminal = state.empty() || fa_states[i].contains_eps();
+		if (state.empty())
+			state = Symbol::Epsilon;
+		automat_state.emplace_back(int(i), state, is_terminal, std::move(transitions[i]));
+	}
 
-	string deriv_log;
-
-	for (size_t i = 0; i < name_states.size(); i++) {
-		string state = name_states[i];
-		FAState::Transitions transit;
-		for (const auto& partial_derivativ : partial_derivatives_by_regex) {
-			// cout << partial_derivativ[0].to_txt() << " ";
-			// cout << partial_derivativ[1].to_txt() << " ";
-			// cout << partial_derivativ[2].to_txt() << endl;
-			deriv_log += partial_derivativ[2].to_txt() + "(" +
-						 partial_derivativ[0].to_txt() + ")" + "\\ =\\ ";
-			if (partial_derivativ[1].to_txt() == "") {
-				deriv_log += "eps\\\\";
-			} else {
-				deriv_log += partial_derivativ[1].to_txt() + "\\\\";
-			}
-
-			if (partial_derivativ[0].to_txt() == state) {
-				// поиск индекс состояния в которое переходим по символу из state
-				auto elem_iter = find(
-					name_states.begin(), name_states.end(), partial_derivativ[1].to_txt());
-				// записываем расстояние между begin и итератором, который указывает на состояние
-				transit[partial_derivativ[2].to_txt()].insert(
-					std::distance(name_states.begin(), elem_iter));
-			}
+	FiniteAutomaton fa(0, automat_state, fa_language);
+	if (log) {
+		string str_state;
+		for (auto& i : automat_state) {
+			str_state += i.identifier + "\\\\ ";
 		}
+		log->set_parameter("oldregex", *this);
+		log->set_parameter("derivative", deriv_log);
+		log->set_parameter("state", str_state);
+		log->set_parameter("result", fa);
+	}
+	return fa;
+}
 
-		if (state.empty() || fa_states[i].contains_eps()) {
-
-			if (state.empty()) {
-				state = Symbol::Epsilon;
+FiniteAutomaton Regex::to_brzozowski(iLogTemplate* log) const {
+	RegexDerivatives derivatives;
+	// номера производных в DAG, по порядку обнаружения
+	vector<int> fa_states = {derivatives.add(*this)};
+	unordered_map<int, int> state_indexes = {{fa_states[0], 0}};
+	vector<FAState::Transitions> transitions(1);
+	std::shared_ptr<Language> fa_language = get_or_make_language();
+	for (size_t i = 0; i < fa_states.size(); i++) {
+		for (const Symbol& symb : fa_language->get_alphabet()) {
+			int derivative = derivatives.derivative(fa_states[i], symb);
+			if (derivative == derivatives.empty_set())
+				continue;
+			auto [it, inserted] = state_indexes.emplace(derivative, fa_states.size());
+			if (inserted) {
+				fa_states.push_back(derivative);
+				transitions.emplace_back();
 			}
-			automat_state.emplace_back(int(i), state, true, transit);
-		} else {
-			automat_state.emplace_back(int(i), state, false, transit);
+			transitions[i][symb].insert(it->second);
 		}
 	}
 
-	string str_state;
-	for (auto& i : automat_state) {
-		str_state += i.identifier + "\\\\ ";
+	vector<FAState> states;
+	for (size_t i = 0; i < fa_states.size(); i++) {
+		string state = derivatives.to_regex(fa_states[i]).to_txt();
+		if (state.empty())
+			state = Symbol::Epsilon;
+		states.emplace_back(
+			int(i), state, derivatives.contains_eps(fa_states[i]), std::move(transitions[i]));
 	}
 
-	FiniteAutomaton fa(0, automat_state, language);
+	FiniteAutomaton fa(0, states, fa_language);
 	if (log) {
 		log->set_parameter("oldregex", *this);
-		log->set_parameter("derivative", deriv_log);
-		log->set_parameter("state", str_state);
 		log->set_parameter("result", fa);
 	}
 	return fa;
@@ -1177,12 +1097,22 @@ bool Regex::is_one_unambiguous(iLogTemplate* log) const {
 	if (log) {
 		log->set_parameter("oldregex", *this);
 	}
-	FiniteAutomaton fa = to_glushkov();
-	bool res = fa.is_deterministic();
+	// автомат Глушкова детерминирован, если за каждой позицией (и в начале) следуют
+	// позиции с попарно различными символами
+	Positions positions = get_positions();
+	auto is_deterministic = [&positions](const vector<int>& following) {
+		set<Symbol> symbols;
+		for (int i : following)
+			if (positions.symbols[i].is_epsilon() || !symbols.insert(positions.symbols[i]).second)
+				return false;
+		return true;
+	};
+	bool res = is_deterministic(positions.first) &&
+			   std::all_of(positions.follow.begin(), positions.follow.end(), is_deterministic);
 	if (log) {
 		log->set_parameter("result", res ? "True" : "False");
 	}
-	return fa.is_deterministic();
+	return res;
 }
 
 Regex Regex::get_one_unambiguous_regex(iLogTemplate* log) const {
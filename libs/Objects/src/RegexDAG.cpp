@@ -0,0 +1,79 @@
+#include "Objects/RegexDAG.h"
+
+bool RegexDAG::Node::operator==(const Node& other) const {
+	return type == other.type && term_l == other.term_l && term_r == other.term_r &&
+		   symbol == other.symbol;
+}
+
+std::size_t RegexDAG::Hasher::operator()(const Node& node) const {
+	std::size_t seed = Symbol::Hasher()(node.symbol);
+	for (int i : {static_cast<int>(node.type), node.term_l, node.term_r})
+		seed ^= std::hash<int>()(i) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	return seed;
+}
+
+int RegexDAG::intern(const Node& node) {
+	auto [it, inserted] = index.emplace(node, nodes.size());
+	if (inserted)
+		nodes.push_back(node);
+	return it->second;
+}
+
+int RegexDAG::add(const Regex& regex) {
+	int term_l = regex.term_l ? add(*static_cast<const Regex*>(regex.term_l)) : -1;
+	int term_r = regex.term_r ? add(*static_cast<const Regex*>(regex.term_r)) : -1;
+	return intern({regex.type, regex.symbol, term_l, term_r});
+}
+
+int RegexDAG::add(Type type, int term_l, int term_r) {
+	return intern({type, Symbol(), term_l, term_r});
+}
+
+int RegexDAG::eps() {
+	return add(Type::eps);
+}
+
+int RegexDAG::symb(const Symbol& symbol) {
+	return intern({Type::symb, symbol, -1, -1});
+}
+
+int RegexDAG::alt(int term_l, int term_r) {
+	return add(Type::alt, term_l, term_r);
+}
+
+int RegexDAG::conc(int term_l, int term_r) {
+	return add(Type::conc, term_l, term_r);
+}
+
+int RegexDAG::star(int term) {
+	return add(Type::star, term);
+}
+
+const RegexDAG::Node& RegexDAG::get_node(int id) const {
+	return nodes[id];
+}
+
+int RegexDAG::size() const {
+	return nodes.size();
+}
+
+void RegexDAG::build(int id, Regex* regex) const {
+	const Node& node = nodes[id];
+	regex->type = node.type;
+	regex->symbol = node.symbol;
+	if (node.term_l != -1) {
+		regex->term_l = new Regex;
+		build(node.term_l, static_cast<Regex*>(regex->term_l));
+	}
+	if (node.term_r != -1) {
+		regex->term_r = new Regex;
+		build(node.term_r, static_cast<Regex*>(regex->term_r));
+	}
+}
+
+Regex RegexDAG::to_regex(int id) const {
+	Regex regex;
+	build(id, &regex);
+	regex.make_language();
+	return regex;
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <iterator>
+
+#include "Objects/RegexDerivatives.h"
+
+using std::string;
+using std::vector;
+
+RegexDerivatives::RegexDerivatives() {
+	empty = dag.symb(Symbol::EmptySet);
+}
+
+int RegexDerivatives::add(const Regex& regex) {
+	return normalize(dag.add(regex));
+}
+
+int RegexDerivatives::empty_set() const {
+	return empty;
+}
+
+int RegexDerivatives::size() const {
+	return dag.size();
+}
+
+Regex RegexDerivatives::to_regex(int id) const {
+	return dag.to_regex(id);
+}
+
+int RegexDerivatives::normalize(int id) {
+	if (auto it = normalized.find(id); it != normalized.end())
+		return it->second;
+
+	// узел копируется: добавление новых узлов может переместить хранилище
+	RegexDAG::Node node = dag.get_node(id);
+	int result = id;
+	switch (node.type) {
+	case Type::eps:
+		result = dag.eps();
+		break;
+	case Type::alt:
+		result = alt(normalize(node.term_l), normalize(node.term_r));
+		break;
+	case Type::conc:
+		result = conc(normalize(node.term_l), normalize(node.term_r));
+		break;
+	case Type::star:
+		result = star(normalize(node.term_l));
+		break;
+	case Type::negative:
+		result = dag.add(Type::negative, normalize(node.term_l));
+		break;
+	default:
+		break;
+	}
+	normalized[id] = result;
+	return result;
+}
+
+void RegexDerivatives::get_alternatives(int id, vector<int>& alternatives) const {
+	while (dag.get_node(id).type == Type::alt) {
+		alternatives.push_back(dag.get_node(id).term_l);
+		id = dag.get_node(id).term_r;
+	}
+	alternatives.push_back(id);
+}
+
+int RegexDerivatives::alt(int term_l, int term_r) {
+	if (term_l == empty || term_l == term_r)
+		return term_r;
+	if (term_r == empty)
+		return term_l;
+
+	// слияние упорядоченных цепочек: w|w = w, слагаемые переставляются в порядок номеров
+	vector<int> alternatives_l, alternatives_r, alternatives;
+	get_alternatives(term_l, alternatives_l);
+	get_alternatives(term_r, alternatives_r);
+	std::set_union(alternatives_l.begin(),
+				   alternatives_l.end(),
+				   alternatives_r.begin(),
+				   alternatives_r.end(),
+				   std::back_inserter(alternatives));
+
+	int result = alternatives.back();
+	for (int i = static_cast<int>(alternatives.size()) - 2; i >= 0; i--)
+		result = dag.alt(alternatives[i], result);
+	return result;
+}
+
+int RegexDerivatives::conc(int term_l, int term_r) {
+	if (term_l == empty || term_r == empty)
+		return empty;
+	if (dag.get_node(term_l).type == Type::eps)
+		return term_r;
+	if (dag.get_node(term_r).type == Type::eps)
+		return term_l;
+
+	RegexDAG::Node node = dag.get_node(term_l);
+	if (node.type == Type::conc)
+		return conc(node.term_l, conc(node.term_r, term_r));
+	return dag.conc(term_l, term_r);
+}
+
+int RegexDerivatives::star(int term) {
+	Type type = dag.get_node(term).type;
+	if (term == empty || type == Type::eps)
+		return dag.eps();
+	if (type == Type::star)
+		return term;
+	return dag.star(term);
+}
+
+bool RegexDerivatives::contains_eps(int id) {
+	if (nullable.size() < dag.size())
+		nullable.resize(dag.size(), -1);
+	if (nullable[id] != -1)
+		return nullable[id];
+
+	RegexDAG::Node node = dag.get_node(id);
+	bool result = false;
+	switch (node.type) {
+	case Type::eps:
+	case Type::star:
+		result = true;
+		break;
+	case Type::alt:
+		result = contains_eps(node.term_l) || contains_eps(node.term_r);
+		break;
+	case Type::conc:
+		result = contains_eps(node.term_l) && contains_eps(node.term_r);
+		break;
+	case Type::negative:
+		result = !contains_eps(node.term_l);
+		break;
+	default:
+		break;
+	}
+	nullable[id] = result;
+	return result;
+}
+
+int RegexDerivatives::derivative(int id, const Symbol& symbol) {
+	auto [symbol_it, inserted] = symbol_ids.emplace(symbol, derivatives.size());
+	int symbol_id = symbol_it->second;
+	if (inserted)
+		derivatives.emplace_back();
+	if (derivatives[symbol_id].size() < dag.size())
+		derivatives[symbol_id].resize(dag.size(), -1);
+	if (derivatives[symbol_id][id] != -1)
+		return derivatives[symbol_id][id];
+
+	RegexDAG::Node node = dag.get_node(id);
+	int result = empty;
+	switch (node.type) {
+	case Type::symb:
+		if (id != empty && node.symbol == symbol)
+			result = dag.eps();
+		break;
+	case Type::alt:
+		result = alt(derivative(node.term_l, symbol), derivative(node.term_r, symbol));
+		break;
+	case Type::conc:
+		result = conc(derivative(node.term_l, symbol), node.term_r);
+		if (contains_eps(node.term_l))
+			result = alt(result, derivative(node.term_r, symbol));
+		break;
+	case Type::star:
+		result = conc(derivative(node.term_l, symbol), id);
+		break;
+	case Type::negative:
+		result = dag.add(Type::negative, derivative(node.term_l, symbol));
+		break;
+	default:
+		break;
+	}
+	// за время рекурсии в хранилище могли появиться новые узлы
+	if (derivatives[symbol_id].size() < dag.size())
+		derivatives[symbol_id].resize(dag.size(), -1);
+	derivatives[symbol_id][id] = result;
+	return result;
+}
+
+int RegexDerivatives::prefix_derivative(int id, const string& word) {
+	for (char c : word) {
+		if (id == empty)
+			break;
+		id = derivative(id, Symbol(c));
+	}
+	return id;
+}
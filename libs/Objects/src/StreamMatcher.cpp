@@ -0,0 +1,57 @@
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#include <vector>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Objects/StreamMatcher.h"
+
+using std::string;
+using std::string_view;
+
+size_t StreamMatcher::bytes_consumed() const {
+	return consumed;
+}
+
+StreamMatcher::Result StreamMatcher::match_file(StreamMatcher& matcher, const string& path) {
+	matcher.reset();
+#ifdef _WIN32
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("StreamMatcher::match_file: cannot open " + path);
+	std::vector<char> buffer(1 << 20);
+	while (file) {
+		file.read(buffer.data(), buffer.size());
+		if (!matcher.feed(string_view(buffer.data(), file.gcount())))
+			break;
+	}
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw std::runtime_error("StreamMatcher::match_file: cannot open " + path);
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == -1) {
+		close(fd);
+		throw std::runtime_error("StreamMatcher::match_file: cannot stat " + path);
+	}
+	size_t size = file_stat.st_size;
+	if (size) {
+		void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			close(fd);
+			throw std::runtime_error("StreamMatcher::match_file: cannot map " + path);
+		}
+		madvise(data, size, MADV_SEQUENTIAL);
+		matcher.feed(string_view(static_cast<const char*>(data), size));
+		munmap(data, size);
+	}
+	close(fd);
+#endif
+	return {matcher.finish(), matcher.bytes_consumed()};
+}
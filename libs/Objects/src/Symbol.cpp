@@ -53,7 +53,7 @@ Symbol& Symbol::operator=(char c) {
 }
 
 bool Symbol::is_epsilon() const {
-	return *this == Symbol::Epsilon;
+	return symbol == Symbol::Epsilon && annote_numbers.empty() && linearize_numbers.empty();
 }
 
 bool Symbol::operator==(const Symbol& other) const {
@@ -3,6 +3,7 @@
 
 #include "Objects/BackRefRegex.h"
 #include "Objects/BaseObject.h"
+#include "Objects/BitParallelMatcher.h"
 #include "Objects/FiniteAutomaton.h"
 #include "Objects/MemoryFiniteAutomaton.h"
 #include "Objects/Regex.h"
@@ -16,8 +17,17 @@ class Tester {
 									 const MemoryFiniteAutomaton*, const BackRefRegex*>;
 
   public:
+	// способ разбора, когда язык задан регуляркой
+	enum class RegexMatching {
+		// автоматы Томпсона, Глушкова, малый НКА и минимальный ДКА
+		automata,
+		// то же и битово-параллельное моделирование автомата Глушкова
+		bit_parallel,
+	};
+
 	/* проверяет на принадлежность языку (1 аргумент)
 	 * слова из тестового сета (генерируется по 2 и 3 арг-там) */
 	static void test(const ParseDevice& language, const Regex& regex, int iteration_step,
-					 iLogTemplate* log = nullptr);
+					 iLogTemplate* log = nullptr,
+					 RegexMatching regex_matching = RegexMatching::automata);
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <chrono>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <regex>
@@ -8,17 +9,21 @@
 
 #include "Tester/Tester.h"
 
+using std::function;
 using std::make_unique;
+using std::pair;
 using std::string;
 using std::to_string;
 using std::unique_ptr;
 using std::vector;
 
-void Tester::test(const ParseDevice& lang, const Regex& regex, int step, iLogTemplate* log) {
+void Tester::test(const ParseDevice& lang, const Regex& regex, int step, iLogTemplate* log,
+				  RegexMatching regex_matching) {
 	iLogTemplate::Table t;
 	iLogTemplate::Plot plot;
 	vector<string> labels;
 	vector<unique_ptr<AbstractMachine>> machines;
+	unique_ptr<BitParallelMatcher> bit_parallel_matcher;
 	if (std::holds_alternative<const Regex*>(lang)) {
 		auto value = std::get<const Regex*>(lang);
 		machines.push_back(make_unique<FiniteAutomaton>(value->to_thompson()));
@@ -36,6 +41,8 @@ void Tester::test(const ParseDevice& lang, const Regex& regex, int step, iLogTem
 		machines.push_back(make_unique<FiniteAutomaton>(
 			dynamic_cast<FiniteAutomaton*>(machines[2].get())->minimize().remove_trap_states()));
 		labels.emplace_back("Minimal DFA");
+		if (regex_matching == RegexMatching::bit_parallel)
+			bit_parallel_matcher = make_unique<BitParallelMatcher>(*value);
 	} else if (std::holds_alternative<const FiniteAutomaton*>(lang)) {
 		auto value = std::get<const FiniteAutomaton*>(lang);
 		machines.push_back(make_unique<FiniteAutomaton>(*value));
@@ -53,8 +60,17 @@ void Tester::test(const ParseDevice& lang, const Regex& regex, int step, iLogTem
 		machines.push_back(make_unique<MemoryFiniteAutomaton>(*value));
 		labels.emplace_back("MFA");
 	}
+	vector<function<pair<int, bool>(const string&)>> parsers;
+	for (const auto& machine : machines)
+		parsers.emplace_back([&machine](const string& word) { return machine->parse(word); });
+	if (bit_parallel_matcher) {
+		parsers.emplace_back([&bit_parallel_matcher](const string& word) {
+			return bit_parallel_matcher->parse(word);
+		});
+		labels.emplace_back("Bit-parallel Glushkov");
+	}
 	/* A counter for parsing objects */
-	int obj_types = static_cast<int>(machines.size());
+	int obj_types = static_cast<int>(parsers.size());
 
 	for (int type = 0; type < obj_types; type++) {
 		vector<long> steps;
@@ -63,7 +79,7 @@ void Tester::test(const ParseDevice& lang, const Regex& regex, int step, iLogTem
 			string word = regex.get_iterated_word(i * step);
 			using clock = std::chrono::high_resolution_clock;
 			const auto start = clock::now();
-			auto [count, is_belongs] = machines[type]->parse(word);
+			auto [count, is_belongs] = parsers[type](word);
 			const auto end = clock::now();
 			const long long elapsed =
 				std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();